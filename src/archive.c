@@ -0,0 +1,362 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "archive.h"
+#include "rmtree.h"
+#include "utils.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+typedef struct {
+  const char *suffix;
+  const char *const *compress;
+  const char *const *decompress;
+} Codec;
+
+static const char *const zstd_compress[] = {"zstd", "-T0", "-q", "-c", NULL};
+static const char *const zstd_decompress[] = {"zstd", "-d", "-q", "-c", NULL};
+static const char *const pigz_compress[] = {"pigz", "-c", NULL};
+static const char *const pigz_decompress[] = {"pigz", "-d", "-c", NULL};
+static const char *const gzip_compress[] = {"gzip", "-c", NULL};
+static const char *const gzip_decompress[] = {"gzip", "-d", "-c", NULL};
+
+// In order of preference; all compress on every core except gzip
+static const Codec codecs[] = {
+    {".tar.zst", zstd_compress, zstd_decompress},
+    {".tar.gz", pigz_compress, pigz_decompress},
+    {".tar.gz", gzip_compress, gzip_decompress},
+};
+
+#define CODEC_COUNT (sizeof(codecs) / sizeof(codecs[0]))
+
+struct ArchiveRestore {
+  int rootfd;
+  int dirfd;           // ARCHIVE_DIR
+  int archivefd;       // Shared with the decompressor: its offset is progress
+  off_t archive_size;
+  pid_t decompress;
+  pid_t tar;
+  bool exited[2];      // decompress, tar
+  bool ok[2];
+  zstr name;
+  zstr archive;        // File name in ARCHIVE_DIR
+  zstr staging;        // Extraction directory in ARCHIVE_DIR
+};
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static bool in_path(const char *program) {
+  const char *path = getenv("PATH");
+  while (path && *path) {
+    size_t len = strcspn(path, ":");
+    Z_CLEANUP(zstr_free) zstr dir = len > 0 ? zstr_from_len(path, len) : zstr_from(".");
+    Z_CLEANUP(zstr_free) zstr full = join_path(zstr_cstr(&dir), program);
+    if (access(zstr_cstr(&full), X_OK) == 0)
+      return true;
+    path += len;
+    if (*path == ':')
+      path++;
+  }
+  return false;
+}
+
+static int cloexec_pipe(int fds[2]) {
+  if (pipe(fds) != 0)
+    return -1;
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return 0;
+}
+
+// Spawns argv with stdin/stdout on the given fds (dup2 clears their
+// close-on-exec flag in the child) and stderr optionally silenced.
+// Returns the pid or -1.
+static pid_t spawn(const char *const *argv, int in, int out, bool quiet) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, in, STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, out, STDOUT_FILENO);
+  if (quiet)
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, argv[0], &actions, NULL, (char *const *)argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  return err == 0 ? pid : -1;
+}
+
+static bool wait_ok(pid_t pid) {
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR)
+      return false;
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Archive file of a try in the archive directory and the codec to read it
+// with, -1 if none
+static int find_archive(int dirfd, const char *name, zstr *archive) {
+  for (size_t c = 0; c < CODEC_COUNT; c++) {
+    zstr file = zstr_from(name);
+    zstr_cat(&file, codecs[c].suffix);
+    struct stat sb;
+    if (fstatat(dirfd, zstr_cstr(&file), &sb, 0) == 0 && S_ISREG(sb.st_mode) &&
+        in_path(codecs[c].decompress[0])) {
+      *archive = file;
+      return (int)c;
+    }
+    zstr_free(&file);
+  }
+  return -1;
+}
+
+size_t archive_name_len(const char *file) {
+  size_t len = strlen(file);
+  for (size_t c = 0; c < CODEC_COUNT; c++) {
+    size_t suffix_len = strlen(codecs[c].suffix);
+    if (len > suffix_len && strcmp(file + len - suffix_len, codecs[c].suffix) == 0)
+      return len - suffix_len;
+  }
+  return 0;
+}
+
+// ============================================================================
+// Packing
+// ============================================================================
+
+static bool newer_inside(int dirfd, time_t cutoff) {
+  DIR *d = fdopendir(dirfd);
+  if (!d) {
+    close(dirfd);
+    return true;  // Can't tell: treat as in use
+  }
+  bool newer = false;
+  struct dirent *de;
+  while (!newer && (de = readdir(d)) != NULL) {
+    if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+      continue;
+    struct stat sb;
+    if (fstatat(dirfd, de->d_name, &sb, AT_SYMLINK_NOFOLLOW) != 0)
+      continue;
+    if (sb.st_mtime > cutoff) {
+      newer = true;
+    } else if (S_ISDIR(sb.st_mode)) {
+      int fd = openat(dirfd, de->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      newer = fd >= 0 && newer_inside(fd, cutoff);
+    }
+  }
+  closedir(d);
+  return newer;
+}
+
+bool archive_untouched_since(const char *root, const char *name, time_t cutoff) {
+  Z_CLEANUP(zstr_free) zstr path = join_path(root, name);
+  struct stat sb;
+  if (lstat(zstr_cstr(&path), &sb) != 0 || !S_ISDIR(sb.st_mode) || sb.st_mtime > cutoff)
+    return false;
+  int fd = open(zstr_cstr(&path), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  return fd >= 0 && !newer_inside(fd, cutoff);
+}
+
+int archive_pack(const char *root, const char *name, time_t last_activity,
+                 uint64_t *bytes, zstr *err) {
+  if (strchr(name, '/')) {
+    zstr_cat(err, "not a try directory");
+    return -1;
+  }
+
+  const Codec *codec = NULL;
+  for (size_t c = 0; c < CODEC_COUNT && !codec; c++) {
+    if (in_path(codecs[c].compress[0]))
+      codec = &codecs[c];
+  }
+  if (!codec || !in_path("tar")) {
+    zstr_cat(err, "needs tar and one of zstd, pigz or gzip");
+    return -1;
+  }
+
+  int rootfd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (rootfd < 0) {
+    zstr_fmt(err, "%s: %s", root, strerror(errno));
+    return -1;
+  }
+  if (mkdirat(rootfd, ARCHIVE_DIR, 0755) != 0 && errno != EEXIST) {
+    zstr_fmt(err, "%s/%s: %s", root, ARCHIVE_DIR, strerror(errno));
+    close(rootfd);
+    return -1;
+  }
+
+  Z_CLEANUP(zstr_free) zstr archive = zstr_from(ARCHIVE_DIR "/");
+  zstr_cat(&archive, name);
+  zstr_cat(&archive, codec->suffix);
+  Z_CLEANUP(zstr_free) zstr tmp = zstr_dup(&archive);
+  zstr_fmt(&tmp, ".%d", (int)getpid());
+
+  struct stat sb;
+  if (fstatat(rootfd, zstr_cstr(&archive), &sb, 0) == 0) {
+    zstr_fmt(err, "%s already exists", zstr_cstr(&archive));
+    close(rootfd);
+    return -1;
+  }
+  int outfd = openat(rootfd, zstr_cstr(&tmp), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  int fds[2];
+  if (outfd < 0 || cloexec_pipe(fds) != 0) {
+    zstr_fmt(err, "%s: %s", zstr_cstr(&tmp), strerror(errno));
+    if (outfd >= 0) {
+      close(outfd);
+      unlinkat(rootfd, zstr_cstr(&tmp), 0);
+    }
+    close(rootfd);
+    return -1;
+  }
+
+  // tar -C root -cf - ./name | <compressor> > tmp. "./" keeps names that
+  // start with '-' from being read as options.
+  Z_CLEANUP(zstr_free) zstr member = zstr_from("./");
+  zstr_cat(&member, name);
+  const char *tar_argv[] = {"tar", "-C", root, "-cf", "-", zstr_cstr(&member), NULL};
+  pid_t tar = spawn(tar_argv, STDIN_FILENO, fds[1], false);
+  pid_t compress = spawn(codec->compress, fds[0], outfd, false);
+  close(fds[0]);
+  close(fds[1]);
+  bool ok = tar > 0 && compress > 0;
+  if (tar > 0)
+    ok = wait_ok(tar) && ok;
+  if (compress > 0)
+    ok = wait_ok(compress) && ok;
+
+  // Durable before the directory goes away; stamped with the last activity
+  struct timespec times[2] = {{.tv_sec = last_activity}, {.tv_sec = last_activity}};
+  ok = ok && fsync(outfd) == 0 && futimens(outfd, times) == 0 && fstat(outfd, &sb) == 0;
+  close(outfd);
+  if (!ok || renameat(rootfd, zstr_cstr(&tmp), rootfd, zstr_cstr(&archive)) != 0) {
+    zstr_cat(err, "packing failed");
+    unlinkat(rootfd, zstr_cstr(&tmp), 0);
+    close(rootfd);
+    return -1;
+  }
+  *bytes = (uint64_t)sb.st_size;
+
+  // The archive is complete: a directory left behind only shadows it
+  const char *names[] = {name};
+  if (rmtree_remove(rootfd, names, 1) != 0) {
+    zstr_fmt(err, "archived, but removing the directory failed: %s", strerror(errno));
+    close(rootfd);
+    return -1;
+  }
+  close(rootfd);
+  return 0;
+}
+
+// ============================================================================
+// Restoring
+// ============================================================================
+
+ArchiveRestore *archive_restore_start(const char *root, const char *name) {
+  if (strchr(name, '/') || !in_path("tar"))
+    return NULL;
+
+  ArchiveRestore *r = calloc(1, sizeof(ArchiveRestore));
+  if (!r)
+    return NULL;
+  r->rootfd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  r->dirfd = r->rootfd >= 0
+                 ? openat(r->rootfd, ARCHIVE_DIR, O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+                 : -1;
+  int codec = r->dirfd >= 0 ? find_archive(r->dirfd, name, &r->archive) : -1;
+  if (codec < 0) {
+    if (r->dirfd >= 0)
+      close(r->dirfd);
+    if (r->rootfd >= 0)
+      close(r->rootfd);
+    free(r);
+    return NULL;
+  }
+  r->name = zstr_from(name);
+  r->staging = zstr_dup(&r->archive);
+  zstr_fmt(&r->staging, ".restore.%d", (int)getpid());
+
+  struct stat sb;
+  r->archivefd = openat(r->dirfd, zstr_cstr(&r->archive), O_RDONLY | O_CLOEXEC);
+  r->archive_size = r->archivefd >= 0 && fstat(r->archivefd, &sb) == 0 ? sb.st_size : 0;
+
+  int fds[2] = {-1, -1};
+  Z_CLEANUP(zstr_free) zstr archive_dir = join_path(root, ARCHIVE_DIR);
+  Z_CLEANUP(zstr_free) zstr staging_path = join_path(zstr_cstr(&archive_dir),
+                                                     zstr_cstr(&r->staging));
+  if (r->archivefd >= 0 && mkdirat(r->dirfd, zstr_cstr(&r->staging), 0755) == 0 &&
+      cloexec_pipe(fds) == 0) {
+    // Output goes to the selector's screen: keep both tools quiet
+    const char *tar_argv[] = {"tar", "-C", zstr_cstr(&staging_path), "-xf", "-", NULL};
+    r->decompress = spawn(codecs[codec].decompress, r->archivefd, fds[1], true);
+    r->tar = spawn(tar_argv, fds[0], STDOUT_FILENO, true);
+    close(fds[0]);
+    close(fds[1]);
+  }
+  // A tool that didn't start counts as failed
+  r->exited[0] = r->decompress <= 0;
+  r->exited[1] = r->tar <= 0;
+  return r;
+}
+
+bool archive_restore_done(ArchiveRestore *r, double *fraction) {
+  pid_t pids[2] = {r->decompress, r->tar};
+  for (int i = 0; i < 2; i++) {
+    int status;
+    if (!r->exited[i] && waitpid(pids[i], &status, WNOHANG) == pids[i]) {
+      r->exited[i] = true;
+      r->ok[i] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+  }
+
+  off_t pos = r->archivefd >= 0 ? lseek(r->archivefd, 0, SEEK_CUR) : 0;
+  *fraction = r->archive_size > 0 && pos > 0 ? (double)pos / (double)r->archive_size : 0.0;
+  if (*fraction > 1.0)
+    *fraction = 1.0;
+  return r->exited[0] && r->exited[1];
+}
+
+int archive_restore_finish(ArchiveRestore *r) {
+  pid_t pids[2] = {r->decompress, r->tar};
+  for (int i = 0; i < 2; i++) {
+    if (!r->exited[i])
+      r->ok[i] = wait_ok(pids[i]);
+  }
+
+  Z_CLEANUP(zstr_free) zstr extracted = join_path(zstr_cstr(&r->staging), zstr_cstr(&r->name));
+  bool ok = r->ok[0] && r->ok[1] &&
+            renameat(r->dirfd, zstr_cstr(&extracted), r->rootfd, zstr_cstr(&r->name)) == 0;
+  if (ok)
+    unlinkat(r->dirfd, zstr_cstr(&r->archive), 0);
+
+  // Empty after a successful rename, a partial extraction otherwise
+  const char *staging = zstr_cstr(&r->staging);
+  rmtree_remove(r->dirfd, &staging, 1);
+
+  if (r->archivefd >= 0)
+    close(r->archivefd);
+  close(r->dirfd);
+  close(r->rootfd);
+  zstr_free(&r->name);
+  zstr_free(&r->archive);
+  zstr_free(&r->staging);
+  free(r);
+  return ok ? 0 : -1;
+}
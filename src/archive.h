@@ -0,0 +1,55 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "libs/zstr.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// ============================================================================
+// Archived tries
+// ============================================================================
+//
+// `try archive` packs cold tries into <root>/.archive/<name>.tar.zst with a
+// `tar | zstd -T0` pipeline (pigz, then gzip, giving .tar.gz when zstd isn't
+// installed) and removes the directory. The archive's mtime is the try's
+// last activity, so it keeps its place in the selector, where the scan lists
+// it as an archived entry.
+//
+// Selecting an archived try restores it: the archive is streamed through the
+// decompressor into tar, extracted into a staging directory under .archive
+// and renamed into place once complete, then the archive is removed.
+
+#define ARCHIVE_DIR ".archive"
+#define ARCHIVE_DEFAULT_DAYS 90   // `try archive` without --days
+
+// Length of the try name in an archive file name ("foo.tar.zst" -> 3), 0 if
+// the file isn't an archive
+size_t archive_name_len(const char *file);
+
+// True if nothing in root/name was modified after cutoff (a top-level mtime
+// misses edits deeper in the tree). Stops at the first newer file.
+bool archive_untouched_since(const char *root, const char *name, time_t cutoff);
+
+// Packs root/name, stamps the archive with last_activity and removes the
+// directory. Returns 0, or -1 with a message in *err. On success *bytes is
+// the archive size.
+int archive_pack(const char *root, const char *name, time_t last_activity,
+                 uint64_t *bytes, zstr *err);
+
+typedef struct ArchiveRestore ArchiveRestore;
+
+// Starts extracting the archive of root/name in the background. Returns NULL
+// if there is no archive or its decompressor can't be started.
+ArchiveRestore *archive_restore_start(const char *root, const char *name);
+
+// Non-blocking: true once extraction finished. *fraction is the share of the
+// archive read so far.
+bool archive_restore_done(ArchiveRestore *r, double *fraction);
+
+// Waits for extraction, moves the directory into place, removes the archive
+// and frees r. Returns 0 on success; on failure the archive is kept.
+int archive_restore_finish(ArchiveRestore *r);
+
+#endif // ARCHIVE_H
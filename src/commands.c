@@ -1,18 +1,25 @@
 // Feature test macros for cross-platform compatibility
 #if defined(__APPLE__)
 #define _DARWIN_C_SOURCE
-#include <mach-o/dyld.h>
 #else
 #define _GNU_SOURCE
 #endif
 
 #include "commands.h"
+#include "archive.h"
 #include "config.h"
+#include "entries.h"
+#include "executor.h"
+#include "fuzzy.h"
+#include "history.h"
+#include "sizes.h"
 #include "tui.h"
 #include "utils.h"
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -32,7 +39,7 @@ int run_script(const char *script, bool exec_mode) {
     return 0;
   }
 
-  // Direct mode: execute via bash, then print cd hint if present
+  // Direct mode: execute the script, then print cd hint if present
   // We run everything except cd (which can't work in subprocess)
   // Then print the cd command as a hint
 
@@ -76,20 +83,25 @@ int run_script(const char *script, bool exec_mode) {
       }
     }
 
-    Z_CLEANUP(zstr_free) zstr cmd = zstr_from("/usr/bin/env bash -c '");
-    // Escape single quotes in script
-    const char *s = zstr_cstr(&exec_script);
-    while (*s) {
-      if (*s == '\'') {
-        zstr_cat(&cmd, "'\\''");
-      } else {
-        zstr_push(&cmd, *s);
+    // Run natively when possible; bash is only needed for syntax the
+    // executor doesn't understand
+    int rc = exec_script_native(zstr_cstr(&exec_script));
+    if (rc < 0) {
+      Z_CLEANUP(zstr_free) zstr cmd = zstr_from("/usr/bin/env bash -c '");
+      // Escape single quotes in script
+      const char *s = zstr_cstr(&exec_script);
+      while (*s) {
+        if (*s == '\'') {
+          zstr_cat(&cmd, "'\\''");
+        } else {
+          zstr_push(&cmd, *s);
+        }
+        s++;
       }
-      s++;
-    }
-    zstr_cat(&cmd, "'");
+      zstr_cat(&cmd, "'");
 
-    int rc = system(zstr_cstr(&cmd));
+      rc = system(zstr_cstr(&cmd));
+    }
     if (rc != 0) {
       return 1;
     }
@@ -192,9 +204,16 @@ static zstr build_delete_script(const char *base_path, vec_zstr *names) {
   Z_CLEANUP(zstr_free) zstr escaped_base = shell_escape(base_path);
   zstr_fmt(&script, "cd %s && \\\n", zstr_cstr(&escaped_base));
 
-  // Per-item delete commands
+  // Per-item delete commands, only for directories that still exist: the
+  // selector has already deleted (or trashed) the rest, and a failing
+  // [[ -d ]] would cut the && chain and fail the whole script
   zstr *iter;
   vec_foreach(names, iter) {
+    Z_CLEANUP(zstr_free) zstr full_path = join_path(base_path, zstr_cstr(iter));
+    struct stat sb;
+    if (stat(zstr_cstr(&full_path), &sb) != 0 || !S_ISDIR(sb.st_mode)) {
+      continue;
+    }
     Z_CLEANUP(zstr_free) zstr escaped_name = shell_escape(zstr_cstr(iter));
     zstr_fmt(&script, "  [[ -d %s ]] && rm -rf %s && \\\n",
              zstr_cstr(&escaped_name), zstr_cstr(&escaped_name));
@@ -352,23 +371,7 @@ void cmd_init(int argc, char **argv, const char *tries_path) {
   // Get the path to this executable using realpath for absolute path
   char exe_path[1024];
   char *resolved_path = NULL;
-  bool got_path = false;
-
-  // Try /proc/self/exe first (Linux)
-  ssize_t len = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
-  if (len != -1) {
-    exe_path[len] = '\0';
-    got_path = true;
-  }
-#ifdef __APPLE__
-  else {
-    // Try _NSGetExecutablePath on macOS
-    uint32_t size = sizeof(exe_path);
-    if (_NSGetExecutablePath(exe_path, &size) == 0) {
-      got_path = true;
-    }
-  }
-#endif
+  bool got_path = self_exe_path(exe_path, sizeof(exe_path));
 
   // Resolve to absolute path, handling symlinks
   const char *self_path;
@@ -467,17 +470,265 @@ zstr cmd_worktree(int argc, char **argv, const char *tries_path) {
   }
 }
 
+// ============================================================================
+// List command - prints directly, or as a printf script in exec mode
+// ============================================================================
+
+// Sort key of a listed entry, copied out of the store so the comparison
+// needs no store at hand
+typedef struct {
+  uint64_t bytes; // Only set for --by-size
+  float score;
+  uint32_t id;
+} ListKey;
+
+Z_VEC_GENERATE_IMPL(ListKey, ListKey)
+
+// Score desc, then scan order, like the selector
+static inline bool lists_by_score(ListKey a, ListKey b) {
+  return a.score > b.score || (a.score == b.score && a.id < b.id);
+}
+
+Z_SORT_GENERATE_IMPL(ListKey, by_score, lists_by_score)
+
+// Largest first, score order among equal sizes
+static inline bool lists_by_size(ListKey a, ListKey b) {
+  return a.bytes > b.bytes || (a.bytes == b.bytes && lists_by_score(a, b));
+}
+
+Z_SORT_GENERATE_IMPL(ListKey, by_size, lists_by_size)
+
+// Fills `lines` with the listing, one entry per line without the newline.
+// Returns false (after printing usage) on bad arguments.
+static bool list_lines(int argc, char **argv, const char *tries_path, vec_zstr *lines) {
+  bool by_size = false;
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--by-size") == 0) {
+      by_size = true;
+    } else {
+      fprintf(stderr, "Usage: try list [--by-size]\n");
+      return false;
+    }
+  }
+
+  EntryStore store = {0};
+  entry_store_scan(&store, tries_path, time(NULL));
+
+  if (by_size) {
+    // Cached sizes where the tree is unchanged, walk the rest
+    sizes_load(&store);
+    SizeRefresh refresh;
+    if (size_refresh_start(&refresh, &store)) {
+      while (size_refresh_active(&refresh)) {
+        poll(NULL, 0, 10);
+        size_refresh_poll(&refresh, &store);
+      }
+    }
+    size_refresh_finish(&refresh, &store);
+  }
+
+  vec_ListKey order = {0};
+  for (size_t i = 0; i < entry_count(&store); i++) {
+    ListKey key = {
+        .bytes = by_size ? entry_size(&store, i)->bytes : 0,
+        .score = fuzzy_score(&store, i, ZSV("")),
+        .id = (uint32_t)i,
+    };
+    vec_push_ListKey(&order, key);
+  }
+
+  if (by_size) {
+    zsort_by_size(order.data, order.length);
+  } else {
+    zsort_by_score(order.data, order.length);
+  }
+
+  // Same layout as `du -sh`: size, tab, name
+  for (size_t i = 0; i < order.length; i++) {
+    size_t entry = order.data[i].id;
+    zstr line = zstr_init();
+    if (by_size) {
+      Z_CLEANUP(zstr_free) zstr size_str = format_size(entry_size(&store, entry)->bytes);
+      zstr_fmt(&line, "%s\t", zstr_cstr(&size_str));
+    }
+    zstr_cat(&line, entry_name(&store, entry));
+    vec_push_zstr(lines, line);
+  }
+
+  vec_free_ListKey(&order);
+  entry_store_free(&store);
+  return true;
+}
+
+static void free_lines(vec_zstr *lines) {
+  zstr *line;
+  vec_foreach(lines, line) {
+    zstr_free(line);
+  }
+  vec_free_zstr(lines);
+}
+
+int cmd_list(int argc, char **argv, const char *tries_path) {
+  vec_zstr lines = {0};
+  if (!list_lines(argc, argv, tries_path, &lines)) {
+    return 1;
+  }
+
+  zstr *line;
+  vec_foreach(&lines, line) {
+    printf("%s\n", zstr_cstr(line));
+  }
+
+  free_lines(&lines);
+  return 0;
+}
+
+// The listing as a script for the shell function, which evals stdout
+static zstr build_list_script(int argc, char **argv, const char *tries_path) {
+  zstr script = zstr_init();
+  vec_zstr lines = {0};
+  if (!list_lines(argc, argv, tries_path, &lines)) {
+    return script;  // Return empty script
+  }
+
+  if (lines.length == 0) {
+    zstr_cat(&script, "true\n");
+  } else {
+    zstr_cat(&script, "printf '%s\\n'");
+    zstr *line;
+    vec_foreach(&lines, line) {
+      Z_CLEANUP(zstr_free) zstr escaped = shell_escape(zstr_cstr(line));
+      zstr_fmt(&script, " %s", zstr_cstr(&escaped));
+    }
+    zstr_push(&script, '\n');
+  }
+
+  free_lines(&lines);
+  return script;
+}
+
+// ============================================================================
+// Archive command - prints directly (headless)
+// ============================================================================
+
+int cmd_archive(int argc, char **argv, const char *tries_path) {
+  int days = ARCHIVE_DEFAULT_DAYS;
+  bool dry_run = false;
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--dry-run") == 0) {
+      dry_run = true;
+    } else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+      days = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Usage: try archive [--days N] [--dry-run]\n");
+      return 1;
+    }
+  }
+
+  time_t now = time(NULL);
+  time_t cutoff = now - (time_t)days * 86400;
+
+  // Never pull the directory out from under the calling shell
+  char cwd[4096];
+  if (getcwd(cwd, sizeof(cwd)) == NULL) {
+    cwd[0] = '\0';
+  }
+
+  EntryStore store = {0};
+  entry_store_scan(&store, tries_path, now);
+
+  int failed = 0;
+  size_t archived = 0;
+  uint64_t archived_bytes = 0;
+  for (size_t i = 0; i < entry_count(&store); i++) {
+    const char *name = entry_name(&store, i);
+    if (entry_archived(&store, i) || entry_mtime(&store, i) > cutoff) {
+      continue;
+    }
+    Z_CLEANUP(zstr_free) zstr path = entry_path(&store, i);
+    size_t path_len = zstr_len(&path);
+    if (strncmp(cwd, zstr_cstr(&path), path_len) == 0 &&
+        (cwd[path_len] == '\0' || cwd[path_len] == '/')) {
+      fprintf(stderr, "Skipping %s (current directory)\n", name);
+      continue;
+    }
+    // Last activity only covers the top level; look for newer files inside
+    if (!archive_untouched_since(tries_path, name, cutoff)) {
+      continue;
+    }
+
+    Z_CLEANUP(zstr_free) zstr age = format_relative_time(entry_mtime(&store, i), now);
+    if (dry_run) {
+      fprintf(stderr, "Would archive %s (%s)\n", name, zstr_cstr(&age));
+      archived++;
+      continue;
+    }
+
+    fprintf(stderr, "Archiving %s (%s)... ", name, zstr_cstr(&age));
+    fflush(stderr);
+    uint64_t bytes = 0;
+    Z_CLEANUP(zstr_free) zstr err = zstr_init();
+    if (archive_pack(tries_path, name, entry_mtime(&store, i), &bytes, &err) != 0) {
+      fprintf(stderr, "failed: %s\n", zstr_cstr(&err));
+      failed++;
+      continue;
+    }
+    Z_CLEANUP(zstr_free) zstr size_str = format_size(bytes);
+    fprintf(stderr, "%s\n", zstr_cstr(&size_str));
+    archived++;
+    archived_bytes += bytes;
+  }
+  entry_store_free(&store);
+
+  if (archived == 0 && failed == 0) {
+    fprintf(stderr, "Nothing untouched for %d days.\n", days);
+  } else if (!dry_run && archived > 0) {
+    Z_CLEANUP(zstr_free) zstr total = format_size(archived_bytes);
+    fprintf(stderr, "Archived %zu director%s into %s/%s (%s).\n", archived,
+            archived == 1 ? "y" : "ies", tries_path, ARCHIVE_DIR, zstr_cstr(&total));
+  }
+  return failed > 0 ? 1 : 0;
+}
+
 // ============================================================================
 // Selector command - returns script
 // ============================================================================
 
-zstr cmd_selector(int argc, char **argv, const char *tries_path, TestParams *test) {
+zstr cmd_selector(int argc, char **argv, const vec_zstr *roots, TestParams *test) {
   const char *initial_filter = (argc > 0) ? argv[0] : NULL;
+  const char *tries_path = zstr_cstr(&roots->data[0]);
 
-  SelectionResult result = run_selector(tries_path, initial_filter, test);
+  SelectionResult result = run_selector(roots, initial_filter, test);
 
   zstr script = zstr_init();
 
+  // Record the visit for frecency ranking in the history of the root it
+  // belongs to; a nested directory counts as a visit to its try
+  if (result.type == ACTION_CD || result.type == ACTION_MKDIR) {
+    const char *path = zstr_cstr(&result.path);
+    const char *root = NULL;
+    size_t root_len = 0;
+    zstr *r;
+    vec_foreach(roots, r) {
+      size_t len = zstr_len(r);
+      if (len > root_len && strncmp(path, zstr_cstr(r), len) == 0 && path[len] == '/') {
+        root = zstr_cstr(r);
+        root_len = len;
+      }
+    }
+    if (root) {
+      Z_CLEANUP(zstr_free) zstr name = zstr_from_len(path + root_len + 1,
+                                                    strcspn(path + root_len + 1, "/"));
+      history_record(root, zstr_cstr(&name), time(NULL));
+    } else {
+      const char *slash = strrchr(path, '/');
+      if (slash)
+        history_record(tries_path, slash + 1, time(NULL));
+    }
+  } else if (result.type == ACTION_RENAME) {
+    history_record(tries_path, zstr_cstr(&result.rename_new_name), time(NULL));
+  }
+
   if (result.type == ACTION_CD) {
     script = build_cd_script(zstr_cstr(&result.path));
   } else if (result.type == ACTION_MKDIR) {
@@ -509,12 +760,14 @@ zstr cmd_selector(int argc, char **argv, const char *tries_path, TestParams *tes
 // Route subcommands (for exec mode or main routing)
 // ============================================================================
 
-zstr cmd_route(int argc, char **argv, const char *tries_path, TestParams *test) {
+zstr cmd_route(int argc, char **argv, const vec_zstr *roots, TestParams *test) {
   // No subcommand = interactive selector
   if (argc == 0) {
-    return cmd_selector(0, NULL, tries_path, test);
+    return cmd_selector(0, NULL, roots, test);
   }
 
+  const char *tries_path = zstr_cstr(&roots->data[0]);
+
   const char *subcmd = argv[0];
 
   // Handle flags that may be passed through shell wrapper
@@ -530,12 +783,20 @@ zstr cmd_route(int argc, char **argv, const char *tries_path, TestParams *test)
     extern bool tui_no_colors;
     tui_no_colors = true;
     // Continue with remaining args
-    return cmd_route(argc - 1, argv + 1, tries_path, test);
+    return cmd_route(argc - 1, argv + 1, roots, test);
   }
 
-  if (strcmp(subcmd, "init") == 0) {
+  if (strcmp(subcmd, "list") == 0) {
+    return build_list_script(argc - 1, argv + 1, tries_path);
+  } else if (strcmp(subcmd, "archive") == 0) {
+    // Reports on stderr only: stdout is eval'd by the shell function, so
+    // the exit status comes back as the script
+    int rc = cmd_archive(argc - 1, argv + 1, tries_path);
+    return zstr_from(rc == 0 ? "true\n" : "false\n");
+  } else if (strcmp(subcmd, "init") == 0) {
     // Init always prints directly
-    cmd_init(argc - 1, argv + 1, tries_path);
+    Z_CLEANUP(zstr_free) zstr list = join_tries_path(roots);
+    cmd_init(argc - 1, argv + 1, zstr_cstr(&list));
     return zstr_init();
   } else if (strcmp(subcmd, "cd") == 0) {
     // Check if argument is a URL (clone shorthand)
@@ -545,7 +806,7 @@ zstr cmd_route(int argc, char **argv, const char *tries_path, TestParams *test)
       return cmd_clone(argc - 1, argv + 1, tries_path);
     }
     // Explicit cd command
-    return cmd_selector(argc - 1, argv + 1, tries_path, test);
+    return cmd_selector(argc - 1, argv + 1, roots, test);
   } else if (strcmp(subcmd, "clone") == 0) {
     return cmd_clone(argc - 1, argv + 1, tries_path);
   } else if (strcmp(subcmd, "worktree") == 0) {
@@ -565,6 +826,6 @@ zstr cmd_route(int argc, char **argv, const char *tries_path, TestParams *test)
     return cmd_worktree(argc - 1, argv + 1, tries_path);
   } else {
     // Treat as query for selector (cd is default)
-    return cmd_selector(argc, argv, tries_path, test);
+    return cmd_selector(argc, argv, roots, test);
   }
 }
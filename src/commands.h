@@ -9,14 +9,25 @@
 // Init command - outputs shell function definition (always prints directly)
 void cmd_init(int argc, char **argv, const char *tries_path);
 
+// List command - prints try directories (most relevant or largest first)
+// Returns exit code
+int cmd_list(int argc, char **argv, const char *tries_path);
+
+// Archive command - packs tries untouched for N days (see archive.h),
+// reporting on stderr. Returns exit code
+int cmd_archive(int argc, char **argv, const char *tries_path);
+
 // Commands return shell scripts to execute
 // Returns empty zstr on error (after printing error to stderr)
 zstr cmd_clone(int argc, char **argv, const char *tries_path);
 zstr cmd_worktree(int argc, char **argv, const char *tries_path);
-zstr cmd_selector(int argc, char **argv, const char *tries_path, TestParams *test);
+
+// The selector and routing take every tries root; roots->data[0] is the
+// primary one the other commands get
+zstr cmd_selector(int argc, char **argv, const vec_zstr *roots, TestParams *test);
 
 // Route subcommands (for exec mode)
-zstr cmd_route(int argc, char **argv, const char *tries_path, TestParams *test);
+zstr cmd_route(int argc, char **argv, const vec_zstr *roots, TestParams *test);
 
 // Execute or print a script
 // exec_mode: true = print with header, false = execute via bash
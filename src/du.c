@@ -0,0 +1,269 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "du.h"
+#include "pool.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+  atomic_uint_fast64_t bytes;
+  atomic_uint_fast64_t files;
+  atomic_size_t pending;   // Directory tasks not yet finished
+} DuEntry;
+
+typedef struct {
+  dev_t dev;
+  ino_t ino;               // 0 = empty slot
+} DuInode;
+
+struct DuWalk {
+  Pool *pool;
+  int rootfd;
+  atomic_bool cancel;
+  atomic_size_t entries_left;
+  DuEntry *entries;
+  size_t count;
+
+  // Inodes with st_nlink > 1 already counted
+  pthread_mutex_t links_lock;
+  DuInode *links;
+  size_t links_cap;
+  size_t links_count;
+};
+
+// A directory being walked; kept open until its children have opened theirs
+typedef struct DuDir {
+  struct DuDir *parent;    // NULL for top-level entries
+  DuWalk *walk;
+  size_t entry;
+  int fd;
+  atomic_size_t refs;      // 1 for its own scan + 1 per unopened child
+  char name[];
+} DuDir;
+
+// ============================================================================
+// Hard link dedupe
+// ============================================================================
+
+static size_t inode_slot(const DuInode *links, size_t cap, dev_t dev, ino_t ino) {
+  uint64_t h = ((uint64_t)ino * 0x9e3779b97f4a7c15ULL) ^ (uint64_t)dev;
+  size_t i = (size_t)(h >> 7) & (cap - 1);
+  while (links[i].ino != 0 && (links[i].ino != ino || links[i].dev != dev))
+    i = (i + 1) & (cap - 1);
+  return i;
+}
+
+// Returns true the first time an inode is seen
+static bool claim_inode(DuWalk *walk, dev_t dev, ino_t ino) {
+  pthread_mutex_lock(&walk->links_lock);
+
+  if (walk->links_count * 2 >= walk->links_cap) {
+    size_t cap = walk->links_cap ? walk->links_cap * 2 : 256;
+    DuInode *links = calloc(cap, sizeof(DuInode));
+    if (!links) {
+      pthread_mutex_unlock(&walk->links_lock);
+      return true; // Can't track it: count it (du without dedupe)
+    }
+    for (size_t i = 0; i < walk->links_cap; i++) {
+      if (walk->links[i].ino != 0)
+        links[inode_slot(links, cap, walk->links[i].dev, walk->links[i].ino)] =
+            walk->links[i];
+    }
+    free(walk->links);
+    walk->links = links;
+    walk->links_cap = cap;
+  }
+
+  size_t i = inode_slot(walk->links, walk->links_cap, dev, ino);
+  bool first = walk->links[i].ino == 0;
+  if (first) {
+    walk->links[i] = (DuInode){.dev = dev, .ino = ino};
+    walk->links_count++;
+  }
+
+  pthread_mutex_unlock(&walk->links_lock);
+  return first;
+}
+
+// ============================================================================
+// Walker
+// ============================================================================
+
+static void count_stat(DuWalk *walk, size_t entry, const struct stat *sb) {
+  DuEntry *e = &walk->entries[entry];
+  if (!S_ISDIR(sb->st_mode))
+    atomic_fetch_add(&e->files, 1);
+  if (sb->st_nlink > 1 && !S_ISDIR(sb->st_mode) &&
+      !claim_inode(walk, sb->st_dev, sb->st_ino))
+    return;
+  atomic_fetch_add(&e->bytes, (uint64_t)sb->st_blocks * 512);
+}
+
+static DuDir *dir_new(DuWalk *walk, DuDir *parent, size_t entry, const char *name) {
+  size_t len = strlen(name);
+  DuDir *dir = malloc(sizeof(DuDir) + len + 1);
+  if (!dir)
+    return NULL;
+  dir->parent = parent;
+  dir->walk = walk;
+  dir->entry = entry;
+  dir->fd = -1;
+  atomic_init(&dir->refs, 1);
+  memcpy(dir->name, name, len + 1);
+  return dir;
+}
+
+static void dir_release(DuDir *dir) {
+  while (dir && atomic_fetch_sub(&dir->refs, 1) == 1) {
+    DuDir *parent = dir->parent;
+    if (dir->fd >= 0)
+      close(dir->fd);
+    free(dir);
+    dir = parent;
+  }
+}
+
+static void entry_task_done(DuWalk *walk, size_t entry) {
+  if (atomic_fetch_sub(&walk->entries[entry].pending, 1) == 1)
+    atomic_fetch_sub(&walk->entries_left, 1);
+}
+
+static void walk_task(void *arg) {
+  DuDir *dir = arg;
+  DuWalk *walk = dir->walk;
+  size_t entry = dir->entry;
+  int pfd = dir->parent ? dir->parent->fd : walk->rootfd;
+
+  if (atomic_load(&walk->cancel)) {
+    dir_release(dir->parent);
+    dir->parent = NULL;
+    dir_release(dir);
+    entry_task_done(walk, entry);
+    return;
+  }
+
+  dir->fd = openat(pfd, dir->name,
+                   O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  struct stat sb;
+  if (dir->fd < 0) {
+    // A top-level entry that isn't a directory (e.g. a symlink)
+    if (!dir->parent && fstatat(pfd, dir->name, &sb, AT_SYMLINK_NOFOLLOW) == 0)
+      count_stat(walk, entry, &sb);
+  }
+  // The parent's fd is only needed to open ours
+  dir_release(dir->parent);
+  dir->parent = NULL;
+  if (dir->fd < 0) {
+    dir_release(dir);
+    entry_task_done(walk, entry);
+    return;
+  }
+
+  if (fstat(dir->fd, &sb) == 0)
+    count_stat(walk, entry, &sb);
+
+  int scan_fd = dup(dir->fd);
+  DIR *d = scan_fd >= 0 ? fdopendir(scan_fd) : NULL;
+  if (!d) {
+    if (scan_fd >= 0)
+      close(scan_fd);
+    dir_release(dir);
+    entry_task_done(walk, entry);
+    return;
+  }
+
+  struct dirent *de;
+  while ((de = readdir(d)) != NULL && !atomic_load(&walk->cancel)) {
+    const char *name = de->d_name;
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+      continue;
+    if (fstatat(dir->fd, name, &sb, AT_SYMLINK_NOFOLLOW) != 0)
+      continue;
+
+    if (!S_ISDIR(sb.st_mode)) {
+      count_stat(walk, entry, &sb);
+      continue;
+    }
+
+    // Subdirectories count their own blocks when they are walked
+    DuDir *child = dir_new(walk, dir, entry, name);
+    if (!child)
+      continue;
+    atomic_fetch_add(&dir->refs, 1);
+    atomic_fetch_add(&walk->entries[entry].pending, 1);
+    pool_submit(walk->pool, walk_task, child);
+  }
+  closedir(d);
+
+  dir_release(dir);
+  entry_task_done(walk, entry);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+DuWalk *du_start(const char *root, const char *const *names, size_t count) {
+  DuWalk *walk = calloc(1, sizeof(DuWalk));
+  if (!walk)
+    return NULL;
+  walk->entries = calloc(count ? count : 1, sizeof(DuEntry));
+  walk->rootfd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  walk->pool = walk->rootfd >= 0 ? pool_create(pool_default_threads()) : NULL;
+  if (!walk->entries || !walk->pool) {
+    if (walk->rootfd >= 0)
+      close(walk->rootfd);
+    free(walk->entries);
+    free(walk);
+    return NULL;
+  }
+  pthread_mutex_init(&walk->links_lock, NULL);
+  walk->count = count;
+  atomic_init(&walk->entries_left, count);
+
+  for (size_t i = 0; i < count; i++) {
+    atomic_init(&walk->entries[i].pending, 1);
+    DuDir *dir = dir_new(walk, NULL, i, names[i]);
+    if (!dir) {
+      entry_task_done(walk, i);
+      continue;
+    }
+    pool_submit(walk->pool, walk_task, dir);
+  }
+  return walk;
+}
+
+void du_usage(DuWalk *walk, size_t index, DuUsage *out) {
+  DuEntry *e = &walk->entries[index];
+  out->bytes = atomic_load(&e->bytes);
+  out->files = atomic_load(&e->files);
+  out->done = atomic_load(&e->pending) == 0;
+}
+
+bool du_done(DuWalk *walk) {
+  return atomic_load(&walk->entries_left) == 0;
+}
+
+void du_free(DuWalk *walk) {
+  if (!walk)
+    return;
+  atomic_store(&walk->cancel, true);
+  pool_destroy(walk->pool);
+  close(walk->rootfd);
+  pthread_mutex_destroy(&walk->links_lock);
+  free(walk->links);
+  free(walk->entries);
+  free(walk);
+}
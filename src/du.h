@@ -0,0 +1,38 @@
+#ifndef DU_H
+#define DU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Background disk usage
+// ============================================================================
+//
+// Measures entries of one directory like `du -s` (allocated blocks), walking
+// subdirectories in parallel on a work-stealing pool with fstatat over
+// openat'd fds. Symlinks are not followed and files with several hard links
+// are counted once per walk, keyed by (dev, inode). Results are published
+// progressively, so callers can poll them from a render loop.
+
+typedef struct DuWalk DuWalk;
+
+typedef struct {
+  uint64_t bytes;   // Allocated size so far
+  uint64_t files;   // Non-directories seen so far
+  bool done;        // The entry has been fully walked
+} DuUsage;
+
+// Starts measuring the named entries of root in the background.
+// Returns NULL if root can't be opened.
+DuWalk *du_start(const char *root, const char *const *names, size_t count);
+
+void du_usage(DuWalk *walk, size_t index, DuUsage *out);
+
+// True once every entry is done
+bool du_done(DuWalk *walk);
+
+// Cancels outstanding work and frees walk (NULL is ignored)
+void du_free(DuWalk *walk);
+
+#endif // DU_H
@@ -0,0 +1,330 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "entries.h"
+#include "archive.h"
+#include "postings.h"
+#include "simd.h"
+#include "utils.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Time-based scoring (matches Ruby reference)
+static float recency_bonus(time_t mtime, time_t now) {
+  double hours_since_access = difftime(now, mtime) / 3600.0;
+  return (float)(3.0 / sqrt(hours_since_access + 1));
+}
+
+void entry_store_init(EntryStore *store, const char *root, time_t now) {
+  *store = (EntryStore){0};
+  store->root = zstr_from(root);
+  vec_push_zstr(&store->roots, zstr_from(root));
+  store->now = now;
+  store->lower_pool = zstr_init();
+  store->name_pool = zstr_init();
+}
+
+void entry_store_clear(EntryStore *store) {
+  zstr *iter;
+  vec_foreach(&store->age_label, iter) {
+    zstr_free(iter);
+  }
+  postings_free(store->postings);
+  store->postings = NULL;
+  zstr_clear(&store->lower_pool);
+  zstr_clear(&store->name_pool);
+  vec_clear_u32(&store->name_off);
+  vec_clear_u32(&store->name_len);
+  vec_clear_float(&store->recency);
+  vec_clear_float(&store->frecency);
+  vec_clear_float(&store->score);
+  vec_clear_time(&store->mtime);
+  vec_clear_zstr(&store->age_label);
+  vec_clear_bool(&store->marked);
+  vec_clear_bool(&store->archived);
+  vec_clear_bool(&store->nested);
+  vec_clear_u32(&store->date);
+  vec_clear_u64(&store->word_start);
+  vec_clear_u32(&store->by_date);
+  vec_clear_u64(&store->match);
+  vec_clear_u64(&store->match_spill);
+  vec_clear_EntrySize(&store->size);
+  vec_clear_EntryGit(&store->git);
+  vec_clear_u32(&store->root_id);
+}
+
+void entry_store_free(EntryStore *store) {
+  entry_store_clear(store);
+  zstr_free(&store->root);
+  zstr *root;
+  vec_foreach(&store->roots, root) {
+    zstr_free(root);
+  }
+  vec_free_zstr(&store->roots);
+  zstr_free(&store->lower_pool);
+  zstr_free(&store->name_pool);
+  vec_free_u32(&store->name_off);
+  vec_free_u32(&store->name_len);
+  vec_free_float(&store->recency);
+  vec_free_float(&store->frecency);
+  vec_free_float(&store->score);
+  vec_free_time(&store->mtime);
+  vec_free_zstr(&store->age_label);
+  vec_free_bool(&store->marked);
+  vec_free_bool(&store->archived);
+  vec_free_bool(&store->nested);
+  vec_free_u32(&store->date);
+  vec_free_u64(&store->word_start);
+  vec_free_u32(&store->by_date);
+  vec_free_u64(&store->match);
+  vec_free_u64(&store->match_spill);
+  vec_free_EntrySize(&store->size);
+  vec_free_EntryGit(&store->git);
+  vec_free_u32(&store->root_id);
+}
+
+uint32_t entry_parse_date(zstr_view name) {
+  static const char layout[] = "dddd-dd-dd-";
+  if (name.len < ENTRY_DATE_PREFIX_LEN)
+    return 0;
+  uint32_t date = 0;
+  for (size_t i = 0; i < ENTRY_DATE_PREFIX_LEN; i++) {
+    char c = name.data[i];
+    if (layout[i] == '-') {
+      if (c != '-')
+        return 0;
+    } else if (!isdigit((unsigned char)c)) {
+      return 0;
+    } else {
+      date = date * 10 + (uint32_t)(c - '0');
+    }
+  }
+  return date;
+}
+
+static int compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// First position of `by_date` whose entry is dated `date` or later
+static size_t date_lower_bound(const EntryStore *store, uint32_t date) {
+  size_t lo = 0, hi = store->by_date.length;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (entry_date(store, store->by_date.data[mid]) < date)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+void entry_dates_between(EntryStore *store, uint32_t lo, uint32_t hi, vec_u32 *out) {
+  vec_clear_u32(out);
+
+  // Entries only ever get appended, so a complete index is a current one
+  size_t count = entry_count(store);
+  if (store->by_date.length != count) {
+    // Sort (date, id) pairs: dates in the high half, ties keep id order
+    uint64_t *keys = malloc(count * sizeof(uint64_t));
+    if (!keys)
+      return;
+    for (size_t i = 0; i < count; i++)
+      keys[i] = (uint64_t)entry_date(store, i) << 32 | (uint32_t)i;
+    qsort(keys, count, sizeof(uint64_t), compare_u64);
+    vec_clear_u32(&store->by_date);
+    vec_reserve_u32(&store->by_date, count);
+    for (size_t i = 0; i < count; i++)
+      store->by_date.data[i] = (uint32_t)keys[i];
+    store->by_date.length = count;
+    free(keys);
+  }
+
+  if (lo > hi)
+    return;
+  size_t begin = date_lower_bound(store, lo);
+  size_t end = hi == UINT32_MAX ? count : date_lower_bound(store, hi + 1);
+  if (end > begin)
+    vec_extend_u32(out, store->by_date.data + begin, end - begin);
+}
+
+size_t entry_store_push(EntryStore *store, zstr_view name, time_t mtime) {
+  size_t len = name.len;
+  uint32_t off = (uint32_t)zstr_len(&store->name_pool);
+
+  // Names keep their NUL so pool offsets double as C strings
+  zstr_cat_len(&store->name_pool, name.data, len);
+  zstr_push(&store->name_pool, '\0');
+  zstr_cat_len(&store->lower_pool, name.data, len);
+  zstr_push(&store->lower_pool, '\0');
+  char *lower = zstr_data(&store->lower_pool) + off;
+  simd_lower(lower, len);
+  uint64_t word_start = 0;
+  for (size_t i = 0; i < len && i < 64; i++) {
+    if (i == 0 || !isalnum((unsigned char)lower[i - 1]))
+      word_start |= 1ULL << i;
+  }
+
+  vec_push_u32(&store->name_off, off);
+  vec_push_u32(&store->name_len, (uint32_t)len);
+  vec_push_float(&store->recency, recency_bonus(mtime, store->now));
+  vec_push_float(&store->frecency, 0.0f);
+  vec_push_float(&store->score, 0.0f);
+  vec_push_bool(&store->nested, false);
+  vec_push_u32(&store->date, entry_parse_date(name));
+  vec_push_u64(&store->word_start, word_start);
+  vec_push_u64(&store->match, 0);
+  vec_push_time(&store->mtime, mtime);
+  vec_push_zstr(&store->age_label, format_relative_time(mtime, store->now));
+  vec_push_bool(&store->marked, false);
+  vec_push_bool(&store->archived, false);
+  vec_push_EntrySize(&store->size, (EntrySize){.dir_mtime = mtime});
+  vec_push_EntryGit(&store->git, (EntryGit){0});
+  vec_push_u32(&store->root_id, 0);
+
+  size_t idx = store->name_off.length - 1;
+  if (store->postings)
+    postings_add(store->postings, (uint32_t)idx, (zstr_view){lower, len});
+  return idx;
+}
+
+uint32_t entry_store_add_root(EntryStore *store, const char *root) {
+  vec_push_zstr(&store->roots, zstr_from(root));
+  return (uint32_t)(store->roots.length - 1);
+}
+
+void entry_store_merge(EntryStore *dst, EntryStore *src, uint32_t root_id) {
+  // Ids line up when nothing was merged before
+  Postings *adopted = NULL;
+  if (entry_count(dst) == 0 && !dst->postings) {
+    adopted = src->postings;
+    src->postings = NULL;
+  }
+
+  for (size_t j = 0; j < entry_count(src); j++) {
+    // Recency and age labels are recomputed against dst->now
+    size_t i = entry_store_push(dst, entry_name_view(src, j), entry_mtime(src, j));
+    dst->frecency.data[i] = src->frecency.data[j];
+    dst->nested.data[i] = src->nested.data[j];
+    dst->size.data[i] = src->size.data[j];
+    dst->archived.data[i] = src->archived.data[j];
+    dst->root_id.data[i] = root_id;
+  }
+
+  if (adopted) {
+    dst->postings = adopted;
+  } else if (!dst->postings && entry_count(dst) >= POSTINGS_MIN_ENTRIES) {
+    dst->postings = postings_build(dst);
+  }
+}
+
+void entry_store_scan(EntryStore *store, const char *root, time_t now) {
+  entry_store_free(store);
+  entry_store_init(store, root, now);
+
+  DIR *d = opendir(root);
+  if (!d)
+    return;
+
+  // Names go straight from the dirent into the pools: stat relative to the
+  // directory rather than building a full path per entry
+  int root_fd = dirfd(d);
+  struct dirent *dir;
+  while ((dir = readdir(d)) != NULL) {
+    if (dir->d_name[0] == '.')
+      continue;
+
+    struct stat sb;
+    if (fstatat(root_fd, dir->d_name, &sb, 0) == 0 && S_ISDIR(sb.st_mode)) {
+      size_t i = entry_store_push(store, zstr_view_from(dir->d_name), sb.st_mtime);
+      entry_size(store, i)->inode = (uint64_t)sb.st_ino;
+    }
+  }
+
+  // Archived tries: the archive's mtime is the try's last activity and its
+  // size the compressed size. A directory of the same name (restored, or
+  // left behind) wins.
+  int archive_fd = openat(root_fd, ARCHIVE_DIR, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  DIR *ad = archive_fd >= 0 ? fdopendir(archive_fd) : NULL;
+  if (!ad && archive_fd >= 0)
+    close(archive_fd);
+  while (ad && (dir = readdir(ad)) != NULL) {
+    size_t len = archive_name_len(dir->d_name);
+    if (len == 0 || dir->d_name[0] == '.')
+      continue;
+
+    char name[sizeof(dir->d_name)];
+    memcpy(name, dir->d_name, len);
+    name[len] = '\0';
+    struct stat sb;
+    if (fstatat(root_fd, name, &sb, 0) == 0 ||
+        fstatat(archive_fd, dir->d_name, &sb, 0) != 0 || !S_ISREG(sb.st_mode))
+      continue;
+
+    size_t i = entry_store_push(store, (zstr_view){name, len}, sb.st_mtime);
+    store->archived.data[i] = true;
+    *entry_size(store, i) = (EntrySize){.dir_mtime = sb.st_mtime,
+                                        .bytes = (uint64_t)sb.st_blocks * 512,
+                                        .known = true};
+  }
+  if (ad)
+    closedir(ad);
+  closedir(d);
+
+  History history;
+  history_load(&history, root, store->now);
+  entry_store_apply_history(store, &history);
+  history_free(&history);
+}
+
+void entry_store_apply_history(EntryStore *store, const History *history) {
+  if (history->count == 0)
+    return;
+
+  for (size_t i = 0; i < entry_count(store); i++) {
+    const HistoryStat *st = history_lookup(history, entry_name(store, i));
+    if (!st)
+      continue;
+
+    // Diminishing returns: a handful of recent visits is worth about as much
+    // as the recency bonus, heavy use can't bury everything else
+    store->frecency.data[i] = (float)log1p(st->frecency);
+
+    if (st->last_access > store->mtime.data[i]) {
+      time_t t = st->last_access;
+      store->mtime.data[i] = t;
+      store->recency.data[i] = recency_bonus(t, store->now);
+      zstr_free(&store->age_label.data[i]);
+      store->age_label.data[i] = format_relative_time(t, store->now);
+    }
+  }
+}
+
+bool entry_store_set_now(EntryStore *store, time_t now) {
+  if (now / 60 == store->now / 60)
+    return false;
+
+  store->now = now;
+  for (size_t i = 0; i < entry_count(store); i++) {
+    time_t mtime = store->mtime.data[i];
+    store->recency.data[i] = recency_bonus(mtime, now);
+    zstr_free(&store->age_label.data[i]);
+    store->age_label.data[i] = format_relative_time(mtime, now);
+  }
+  return true;
+}
+
+zstr entry_path(const EntryStore *s, size_t i) {
+  return join_path(entry_root(s, i), entry_name(s, i));
+}
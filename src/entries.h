@@ -0,0 +1,236 @@
+#ifndef ENTRIES_H
+#define ENTRIES_H
+
+#include "history.h"
+#include "tui.h" // vec_zstr
+#include "libs/zstr.h"
+#include "libs/zvec.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Generate packed column types for the entry store
+Z_VEC_GENERATE_IMPL(uint32_t, u32)
+Z_VEC_GENERATE_IMPL(uint64_t, u64)
+Z_VEC_GENERATE_IMPL(float, float)
+Z_VEC_GENERATE_IMPL(time_t, time)
+Z_VEC_GENERATE_IMPL(bool, bool)
+
+// Disk footprint of an entry, keyed by (inode, directory mtime) in the
+// persisted size cache (see sizes.h)
+typedef struct {
+  uint64_t inode;
+  time_t dir_mtime;    // The directory's own mtime, not last activity
+  uint64_t bytes;      // Allocated size (partial while being measured)
+  uint64_t files;
+  bool known;          // bytes/files are complete for this inode+mtime
+} EntrySize;
+
+Z_VEC_GENERATE_IMPL(EntrySize, EntrySize)
+
+// Git badge of an entry, filled in by the background worker (see gitstatus.h)
+typedef enum {
+  GIT_UNKNOWN = 0,     // Not probed yet
+  GIT_NONE,            // Not a git work tree
+  GIT_REPO,            // Work tree whose index couldn't be read
+  GIT_CLEAN,
+  GIT_DIRTY,
+} GitState;
+
+typedef struct {
+  uint8_t state;       // GitState
+  char branch[47];     // Branch name, or short commit id when detached
+  int64_t index_sec;   // .git/index mtime the state was computed for
+  int64_t index_nsec;
+} EntryGit;
+
+Z_VEC_GENERATE_IMPL(EntryGit, EntryGit)
+
+// Candidate index of large stores (see postings.h)
+typedef struct Postings Postings;
+
+// ============================================================================
+// Entry Store
+// ============================================================================
+//
+// Structure-of-arrays table of try directories. The scoring pass only reads
+// the lowercase name pool, offsets/lengths, recency bonuses and writes scores,
+// so those columns are packed tightly; display-only data (original-case
+// names, delete marks) lives in separate cold columns. The scorer also
+// records which characters matched, one bit per byte of the name; the row
+// painter highlights from those bits, so nothing is rendered ahead of time.
+//
+// Both name pools share the same offsets and keep a NUL after every name, so
+// entry_name()/entry_lower() can be passed straight to C string APIs. The
+// pools are the only copy of the names: matching and rendering read them
+// through entry_name_view()/entry_lower_view().
+
+typedef struct {
+  zstr root;           // Primary tries root (where new tries are created)
+  vec_zstr roots;      // Every root names are relative to, roots[0] == root
+  time_t now;          // Reference time for recency bonuses and age labels
+
+  // Hot columns (scoring + sorting)
+  zstr lower_pool;     // Lowercase names, NUL-separated
+  vec_u32 name_off;    // Offset of each name in both pools
+  vec_u32 name_len;    // Length of each name (excluding NUL)
+  vec_float recency;   // Precomputed 3/sqrt(hours+1) access bonus
+  vec_float frecency;  // Precomputed bonus from the access history
+  vec_float score;     // Last computed score
+  vec_bool nested;     // Subdirectory of a try (see treeindex.h)
+  vec_u32 date;        // Name's YYYY-MM-DD- prefix as YYYYMMDD, 0 if none
+  vec_u64 word_start;  // Bit p: name byte p starts a word (first 64 bytes)
+  vec_u64 match;       // Matched positions of the last query: the bitmask
+                       // itself for names up to 64 bytes, else an offset
+                       // into match_spill
+  vec_u64 match_spill; // Bitmask words of longer names, rebuilt per query
+  Postings *postings;  // Character index, NULL for small stores
+  vec_u32 by_date;     // Ids sorted by date, built by entry_dates_between()
+
+  // Cold columns (display)
+  zstr name_pool;      // Original-case names, NUL-separated
+  vec_time mtime;      // Last activity: directory mtime or last selection
+  vec_zstr age_label;  // Cached format_relative_time() text
+  vec_bool marked;     // Marked for deletion
+  vec_bool archived;   // Packed into the archive directory (see archive.h)
+  vec_EntrySize size;  // Disk usage, filled from the size cache / walker
+  vec_EntryGit git;    // Branch and dirty badge, filled by the git worker
+  vec_u32 root_id;     // Index into roots
+} EntryStore;
+
+void entry_store_init(EntryStore *store, const char *root, time_t now);
+void entry_store_clear(EntryStore *store);
+void entry_store_free(EntryStore *store);
+
+// Appends an entry (the name is copied into both pools), returns its index
+size_t entry_store_push(EntryStore *store, zstr_view name, time_t mtime);
+
+// Date of a "YYYY-MM-DD-" name prefix as YYYYMMDD (so dates compare as
+// integers), 0 if the name has none
+#define ENTRY_DATE_PREFIX_LEN 11
+uint32_t entry_parse_date(zstr_view name);
+
+// Replaces `out` with the ids of the entries dated lo..hi (inclusive), found
+// by binary search in a date-sorted index built on first use
+void entry_dates_between(EntryStore *store, uint32_t lo, uint32_t hi, vec_u32 *out);
+
+// Declares another root for entry_store_merge(), returns its id
+uint32_t entry_store_add_root(EntryStore *store, const char *root);
+
+// Appends the entries of a single-root store (scanned separately) as
+// entries of root_id, keeping their history, size and nesting. An empty
+// store takes over src's postings index; one that grows past
+// POSTINGS_MIN_ENTRIES gets its own.
+void entry_store_merge(EntryStore *dst, EntryStore *src, uint32_t root_id);
+
+// Fills the store with the directories in root (dot-entries skipped) and
+// its archived tries, and folds in the access history
+void entry_store_scan(EntryStore *store, const char *root, time_t now);
+
+// Folds access history into the store: frecency bonuses, and selections newer
+// than the directory mtime become the entry's last activity
+void entry_store_apply_history(EntryStore *store, const History *history);
+
+// Moves the reference time forward. Recency bonuses and age labels are only
+// recomputed when `now` falls in a different minute than the cached one.
+// Returns true if anything was recomputed (scores need refreshing).
+bool entry_store_set_now(EntryStore *store, time_t now);
+
+// ============================================================================
+// Accessors (mirror the old TryEntry fields)
+// ============================================================================
+
+static inline size_t entry_count(const EntryStore *s) {
+  return s->name_off.length;
+}
+
+static inline const char *entry_name(const EntryStore *s, size_t i) {
+  return zstr_cstr(&s->name_pool) + s->name_off.data[i];
+}
+
+static inline const char *entry_lower(const EntryStore *s, size_t i) {
+  return zstr_cstr(&s->lower_pool) + s->name_off.data[i];
+}
+
+static inline size_t entry_name_len(const EntryStore *s, size_t i) {
+  return s->name_len.data[i];
+}
+
+static inline zstr_view entry_name_view(const EntryStore *s, size_t i) {
+  return (zstr_view){entry_name(s, i), entry_name_len(s, i)};
+}
+
+static inline zstr_view entry_lower_view(const EntryStore *s, size_t i) {
+  return (zstr_view){entry_lower(s, i), entry_name_len(s, i)};
+}
+
+static inline time_t entry_mtime(const EntryStore *s, size_t i) {
+  return s->mtime.data[i];
+}
+
+static inline uint32_t entry_date(const EntryStore *s, size_t i) {
+  return s->date.data[i];
+}
+
+// Whether name byte pos starts a word (first byte, or after a non-alnum)
+static inline bool entry_word_start(const EntryStore *s, size_t i, size_t pos) {
+  if (pos < 64)
+    return (s->word_start.data[i] >> pos) & 1;
+  return !isalnum((unsigned char)entry_lower(s, i)[pos - 1]);
+}
+
+static inline float entry_score(const EntryStore *s, size_t i) {
+  return s->score.data[i];
+}
+
+static inline const char *entry_age(const EntryStore *s, size_t i) {
+  return zstr_cstr(&s->age_label.data[i]);
+}
+
+#define ENTRY_MATCH_INLINE 64
+
+// Bitmask of the name bytes matched by the last scored query (bit i of word
+// i / 64 is byte i). Only meaningful for entries that matched it.
+static inline const uint64_t *entry_match_mask(const EntryStore *s, size_t i) {
+  if (entry_name_len(s, i) <= ENTRY_MATCH_INLINE)
+    return &s->match.data[i];
+  return s->match_spill.data + s->match.data[i];
+}
+
+static inline bool entry_marked(const EntryStore *s, size_t i) {
+  return s->marked.data[i];
+}
+
+static inline void entry_set_marked(EntryStore *s, size_t i, bool marked) {
+  s->marked.data[i] = marked;
+}
+
+static inline bool entry_nested(const EntryStore *s, size_t i) {
+  return s->nested.data[i];
+}
+
+static inline bool entry_archived(const EntryStore *s, size_t i) {
+  return s->archived.data[i];
+}
+
+static inline EntrySize *entry_size(EntryStore *s, size_t i) {
+  return &s->size.data[i];
+}
+
+static inline EntryGit *entry_git(EntryStore *s, size_t i) {
+  return &s->git.data[i];
+}
+
+static inline uint32_t entry_root_id(const EntryStore *s, size_t i) {
+  return s->root_id.data[i];
+}
+
+static inline const char *entry_root(const EntryStore *s, size_t i) {
+  return zstr_cstr(&s->roots.data[s->root_id.data[i]]);
+}
+
+// Full path of an entry (its root + "/" + name), caller frees
+zstr entry_path(const EntryStore *s, size_t i);
+
+#endif // ENTRIES_H
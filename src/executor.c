@@ -0,0 +1,457 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "executor.h"
+#include "rmtree.h"
+#include "tui.h" // vec_zstr
+#include "utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// ============================================================================
+// Tokenizer
+// ============================================================================
+
+typedef enum {
+  TOK_END,
+  TOK_WORD,
+  TOK_AND,      // &&
+  TOK_OR,       // ||
+  TOK_LPAREN,
+  TOK_RPAREN,
+  TOK_REDIRECT, // >FILE, 2>FILE (target consumed with the operator)
+  TOK_ERROR     // Unsupported syntax
+} TokenType;
+
+static bool is_operator_char(char c) {
+  return c == '(' || c == ')' || c == '&' || c == '|' || c == ';' ||
+         c == '<' || c == '>';
+}
+
+// Characters that would be expanded by the shell outside of quotes
+static bool is_special_char(char c) {
+  return c == '$' || c == '`' || c == '*' || c == '?' || c == '[' ||
+         c == ']' || c == '~' || c == '{' || c == '}' || c == '\\' ||
+         c == '"' || c == '\'' || c == '#';
+}
+
+// Appends $NAME (p points after the $). Returns false for other expansions.
+static bool expand_variable(const char **p, zstr *word) {
+  const char *start = *p;
+  while (**p == '_' || (**p >= 'A' && **p <= 'Z') || (**p >= 'a' && **p <= 'z') ||
+         (*p > start && **p >= '0' && **p <= '9'))
+    (*p)++;
+  if (*p == start)
+    return false;
+  Z_CLEANUP(zstr_free) zstr name = zstr_from_len(start, (size_t)(*p - start));
+  const char *value = getenv(zstr_cstr(&name));
+  if (value)
+    zstr_cat(word, value);
+  return true;
+}
+
+static TokenType next_token(const char **pp, zstr *word) {
+  const char *p = *pp;
+
+  // Skip blanks and backslash-newline continuations
+  while (*p == ' ' || *p == '\t' || (*p == '\\' && p[1] == '\n')) {
+    p += (*p == '\\') ? 2 : 1;
+  }
+  // A bare newline ends the script only if nothing follows it
+  if (*p == '\n') {
+    const char *q = p;
+    while (*q == '\n' || *q == ' ' || *q == '\t')
+      q++;
+    *pp = q;
+    return *q ? TOK_ERROR : TOK_END;
+  }
+  if (!*p) {
+    *pp = p;
+    return TOK_END;
+  }
+
+  TokenType type = TOK_WORD;
+  if (p[0] == '&' && p[1] == '&') {
+    *pp = p + 2;
+    return TOK_AND;
+  }
+  if (p[0] == '|' && p[1] == '|') {
+    *pp = p + 2;
+    return TOK_OR;
+  }
+  if (*p == '(' || *p == ')') {
+    *pp = p + 1;
+    return *p == '(' ? TOK_LPAREN : TOK_RPAREN;
+  }
+  if (*p == '>') {
+    // Redirection: consume the target word as part of the operator
+    p++;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    type = TOK_REDIRECT;
+  } else if (is_operator_char(*p)) {
+    return TOK_ERROR;
+  }
+
+  zstr_clear(word);
+  while (*p && *p != ' ' && *p != '\t' && *p != '\n' && !is_operator_char(*p)) {
+    if (*p == '\'') {
+      // Single quotes: everything literal up to the next quote
+      const char *end = strchr(p + 1, '\'');
+      if (!end)
+        return TOK_ERROR;
+      zstr_cat_len(word, p + 1, (size_t)(end - p - 1));
+      p = end + 1;
+    } else if (*p == '"') {
+      // Double quotes: \-escapes and $NAME expansion only
+      p++;
+      while (*p && *p != '"') {
+        if (*p == '\\' && (p[1] == '"' || p[1] == '\\' || p[1] == '$' ||
+                           p[1] == '`')) {
+          zstr_push(word, p[1]);
+          p += 2;
+        } else if (*p == '$') {
+          p++;
+          if (!expand_variable(&p, word))
+            return TOK_ERROR;
+        } else if (*p == '`') {
+          return TOK_ERROR;
+        } else {
+          zstr_push(word, *p++);
+        }
+      }
+      if (*p != '"')
+        return TOK_ERROR;
+      p++;
+    } else if (is_special_char(*p)) {
+      // [[ and ]] are the only bare words with special characters we accept
+      if ((p[0] == '[' && p[1] == '[') || (p[0] == ']' && p[1] == ']')) {
+        zstr_push(word, p[0]);
+        zstr_push(word, p[1]);
+        p += 2;
+      } else {
+        return TOK_ERROR;
+      }
+    } else {
+      zstr_push(word, *p++);
+    }
+  }
+
+  // A digit directly before > is a file descriptor, e.g. 2>/dev/null
+  if (type == TOK_WORD && *p == '>' && zstr_len(word) == 1 &&
+      zstr_cstr(word)[0] >= '0' && zstr_cstr(word)[0] <= '9') {
+    *pp = p;
+    return next_token(pp, word);
+  }
+
+  *pp = p;
+  return type;
+}
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+typedef struct {
+  vec_zstr args;
+} ScriptCmd;
+
+Z_VEC_GENERATE_IMPL(ScriptCmd, ScriptCmd)
+
+static void free_cmds(vec_ScriptCmd *cmds) {
+  ScriptCmd *cmd;
+  vec_foreach(cmds, cmd) {
+    zstr *arg;
+    vec_foreach(&cmd->args, arg) {
+      zstr_free(arg);
+    }
+    vec_free_zstr(&cmd->args);
+  }
+  vec_free_ScriptCmd(cmds);
+}
+
+// Skips a "( cd A || cd B )" group. A subshell that only changes directory
+// has no effect on the filesystem, so it is dropped. Returns false if the
+// group contains anything else.
+static bool skip_cd_subshell(const char **p) {
+  Z_CLEANUP(zstr_free) zstr word = zstr_init();
+  bool expect_command = true;
+  while (1) {
+    TokenType t = next_token(p, &word);
+    if (t == TOK_RPAREN)
+      return !expect_command;
+    if (t == TOK_WORD) {
+      if (expect_command && strcmp(zstr_cstr(&word), "cd") != 0)
+        return false;
+      expect_command = false;
+    } else if (t == TOK_AND || t == TOK_OR) {
+      if (expect_command)
+        return false;
+      expect_command = true;
+    } else if (t != TOK_REDIRECT) {
+      return false;
+    }
+  }
+}
+
+// Parses an && chain of simple commands. Returns false on unsupported syntax.
+static bool parse_script(const char *script, vec_ScriptCmd *cmds) {
+  const char *p = script;
+  Z_CLEANUP(zstr_free) zstr word = zstr_init();
+  ScriptCmd cur = {0};
+
+  while (1) {
+    TokenType t = next_token(&p, &word);
+    if (t == TOK_WORD) {
+      vec_push_zstr(&cur.args, zstr_dup(&word));
+      continue;
+    }
+    if (t == TOK_LPAREN && cur.args.length == 0) {
+      if (!skip_cd_subshell(&p))
+        break;
+      continue;
+    }
+    if (t == TOK_AND || t == TOK_END) {
+      if (cur.args.length > 0) {
+        vec_push_ScriptCmd(cmds, cur);
+        cur = (ScriptCmd){0};
+      } else if (t == TOK_AND) {
+        break; // Empty command before &&
+      }
+      if (t == TOK_END)
+        return true;
+      continue;
+    }
+    break; // ||, stray ), redirections, unsupported syntax
+  }
+
+  zstr *arg;
+  vec_foreach(&cur.args, arg) {
+    zstr_free(arg);
+  }
+  vec_free_zstr(&cur.args);
+  return false;
+}
+
+// Checks that a parsed command belongs to the supported vocabulary
+static bool is_supported(const ScriptCmd *cmd) {
+  size_t argc = cmd->args.length;
+  const zstr *a = cmd->args.data;
+  const char *name = zstr_cstr(&a[0]);
+
+  if (strcmp(name, "cd") == 0)
+    return argc == 2;
+  if (strcmp(name, "touch") == 0)
+    return argc >= 2;
+  if (strcmp(name, "mkdir") == 0)
+    return argc >= 3 && strcmp(zstr_cstr(&a[1]), "-p") == 0;
+  if (strcmp(name, "mv") == 0)
+    return argc == 3;
+  if (strcmp(name, "rm") == 0)
+    return argc >= 3 && strcmp(zstr_cstr(&a[1]), "-rf") == 0;
+  if (strcmp(name, "[[") == 0)
+    return argc == 4 && strcmp(zstr_cstr(&a[1]), "-d") == 0 &&
+           strcmp(zstr_cstr(&a[3]), "]]") == 0;
+  if (strcmp(name, "git") == 0)
+    return (argc == 4 && strcmp(zstr_cstr(&a[1]), "clone") == 0) ||
+           (argc == 4 && strcmp(zstr_cstr(&a[1]), "worktree") == 0 &&
+            strcmp(zstr_cstr(&a[2]), "add") == 0);
+  return false;
+}
+
+// ============================================================================
+// Commands
+// ============================================================================
+
+static int fail(const char *cmd, const char *path) {
+  fprintf(stderr, "try: %s: %s: %s\n", cmd, path, strerror(errno));
+  return 1;
+}
+
+static int do_touch(int dirfd, const char *path) {
+  if (utimensat(dirfd, path, NULL, 0) == 0)
+    return 0;
+  if (errno != ENOENT)
+    return fail("touch", path);
+  // Like touch(1): create a missing file
+  int fd = openat(dirfd, path, O_WRONLY | O_CREAT | O_NOCTTY | O_CLOEXEC, 0666);
+  if (fd < 0)
+    return fail("touch", path);
+  close(fd);
+  return 0;
+}
+
+static int do_mkdir_p(int dirfd, const char *path) {
+  Z_CLEANUP(zstr_free) zstr tmp = zstr_from(path);
+  char *p = zstr_data(&tmp);
+
+  // Create each intermediate component, then the full path
+  for (char *s = p + 1; *s; s++) {
+    if (*s != '/')
+      continue;
+    *s = '\0';
+    if (mkdirat(dirfd, p, 0777) != 0 && errno != EEXIST)
+      return fail("mkdir", path);
+    *s = '/';
+  }
+  if (mkdirat(dirfd, p, 0777) != 0 && errno != EEXIST)
+    return fail("mkdir", path);
+
+  struct stat sb;
+  if (fstatat(dirfd, p, &sb, 0) != 0 || !S_ISDIR(sb.st_mode)) {
+    errno = ENOTDIR;
+    return fail("mkdir", path);
+  }
+  return 0;
+}
+
+static int do_mv(int dirfd, const char *src, const char *dst) {
+  // Like mv(1): moving onto an existing directory moves into it
+  Z_CLEANUP(zstr_free) zstr target = zstr_from(dst);
+  struct stat sb;
+  if (fstatat(dirfd, dst, &sb, 0) == 0 && S_ISDIR(sb.st_mode)) {
+    const char *base = strrchr(src, '/');
+    zstr_free(&target);
+    target = join_path(dst, base ? base + 1 : src);
+  }
+  if (renameat(dirfd, src, dirfd, zstr_cstr(&target)) != 0)
+    return fail("mv", src);
+  return 0;
+}
+
+static int do_rm_rf(int dirfd, const char *path) {
+  // Refuse the paths rm(1) itself refuses
+  const char *base = strrchr(path, '/');
+  base = base ? base + 1 : path;
+  if (!*base || strcmp(base, ".") == 0 || strcmp(base, "..") == 0) {
+    fprintf(stderr, "try: rm: refusing to remove '%s'\n", path);
+    return 1;
+  }
+
+  // rmtree works on entries of a directory fd: open the parent if needed
+  int parent = dirfd;
+  if (base != path) {
+    Z_CLEANUP(zstr_free) zstr dir = zstr_from_len(path, (size_t)(base - path));
+    parent = openat(dirfd, zstr_cstr(&dir), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (parent < 0)
+      return errno == ENOENT ? 0 : fail("rm", path);
+  }
+
+  int rc = rmtree_remove(parent, &base, 1);
+  int err = errno;
+  if (parent != dirfd)
+    close(parent);
+  errno = err;
+  return rc != 0 ? fail("rm", path) : 0;
+}
+
+static int do_git(int dirfd, const ScriptCmd *cmd) {
+  // posix_spawn has no portable chdir action; we're about to exit anyway
+  if (dirfd != AT_FDCWD && fchdir(dirfd) != 0)
+    return fail("cd", ".");
+
+  char *argv[5] = {0};
+  for (size_t i = 0; i < cmd->args.length && i < 4; i++)
+    argv[i] = zstr_data(&cmd->args.data[i]);
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, "git", NULL, NULL, argv, environ);
+  if (err != 0) {
+    errno = err;
+    return fail("git", argv[1]);
+  }
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR)
+      return fail("git", argv[1]);
+  }
+  return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+}
+
+static int run_cmd(int *dirfd, const ScriptCmd *cmd) {
+  const zstr *a = cmd->args.data;
+  size_t argc = cmd->args.length;
+  const char *name = zstr_cstr(&a[0]);
+
+  if (strcmp(name, "cd") == 0) {
+    int fd = openat(*dirfd, zstr_cstr(&a[1]),
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+      return fail("cd", zstr_cstr(&a[1]));
+    if (*dirfd != AT_FDCWD)
+      close(*dirfd);
+    *dirfd = fd;
+    return 0;
+  }
+  if (strcmp(name, "[[") == 0) {
+    struct stat sb;
+    return (fstatat(*dirfd, zstr_cstr(&a[2]), &sb, 0) == 0 &&
+            S_ISDIR(sb.st_mode)) ? 0 : 1;
+  }
+  if (strcmp(name, "mv") == 0)
+    return do_mv(*dirfd, zstr_cstr(&a[1]), zstr_cstr(&a[2]));
+  if (strcmp(name, "git") == 0)
+    return do_git(*dirfd, cmd);
+
+  // touch / mkdir -p / rm -rf take a list of paths
+  size_t first = strcmp(name, "touch") == 0 ? 1 : 2;
+  int rc = 0;
+  for (size_t i = first; i < argc && rc == 0; i++) {
+    const char *path = zstr_cstr(&a[i]);
+    if (strcmp(name, "touch") == 0)
+      rc = do_touch(*dirfd, path);
+    else if (strcmp(name, "mkdir") == 0)
+      rc = do_mkdir_p(*dirfd, path);
+    else
+      rc = do_rm_rf(*dirfd, path);
+  }
+  return rc;
+}
+
+// ============================================================================
+// Entry point
+// ============================================================================
+
+int exec_script_native(const char *script) {
+  vec_ScriptCmd cmds = {0};
+  if (!parse_script(script, &cmds)) {
+    free_cmds(&cmds);
+    return -1;
+  }
+
+  ScriptCmd *cmd;
+  vec_foreach(&cmds, cmd) {
+    if (!is_supported(cmd)) {
+      free_cmds(&cmds);
+      return -1;
+    }
+  }
+
+  // Run the && chain, stopping at the first failure like bash
+  int dirfd = AT_FDCWD;
+  int rc = 0;
+  vec_foreach(&cmds, cmd) {
+    rc = run_cmd(&dirfd, cmd);
+    if (rc != 0)
+      break;
+  }
+
+  if (dirfd != AT_FDCWD)
+    close(dirfd);
+  free_cmds(&cmds);
+  return rc;
+}
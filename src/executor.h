@@ -0,0 +1,24 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+// ============================================================================
+// Native script executor
+// ============================================================================
+//
+// Runs the scripts produced by the script builders in commands.c without
+// spawning a shell. Only their fixed vocabulary is understood:
+//
+//   cd DIR, touch PATH, mkdir -p PATH, mv SRC DST, [[ -d PATH ]],
+//   rm -rf PATH, git clone URL PATH, git worktree add PATH,
+//   ( cd ... || cd ... )   (subshell cd: no effect, skipped)
+//
+// joined with && and backslash-newline continuations, with words quoted the
+// way shell_escape() quotes them. The whole script is parsed before anything
+// runs, so anything else is rejected without side effects.
+//
+// Returns 0 if every command succeeded, 1 if one failed (later commands in
+// the && chain are skipped, like bash), or -1 if the script uses syntax the
+// executor doesn't support and must be run through bash instead.
+int exec_script_native(const char *script);
+
+#endif // EXECUTOR_H
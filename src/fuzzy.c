@@ -1,170 +1,697 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
 #include "fuzzy.h"
 #include "tui.h"
-#include "tui.h"
 #include <ctype.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-// Helper to check for date prefix (YYYY-MM-DD-)
-static bool has_date_prefix(const char *text) {
-  return (strlen(text) >= 11 && isdigit(text[0]) && isdigit(text[1]) &&
-          isdigit(text[2]) && isdigit(text[3]) && text[4] == '-' &&
-          isdigit(text[5]) && isdigit(text[6]) && text[7] == '-' &&
-          isdigit(text[8]) && isdigit(text[9]) && text[10] == '-');
+// Drops the spilled match masks of the previous query before a new pass
+void fuzzy_reset_matches(EntryStore *store) {
+  vec_clear_u64(&store->match_spill);
 }
 
-void fuzzy_match(TryEntry *entry, const char *query) {
-  // Reset score
-  entry->score = 0.0;
-
-  // Style string for proper nesting (dark date section + match highlights)
-  TuiStyleString ss = tui_start_zstr(&entry->rendered);
+// Match positions of the entry being scored: one word in the entry's column
+// for short names, words appended to the spill pool (dropped again on a
+// miss) for long ones
+typedef struct {
+  uint64_t inline_mask;
+  uint64_t *words;
+  size_t spill_at;
+  bool spilled;
+} MatchMask;
 
-  const char *text = zstr_cstr(&entry->name);
-
-  // 2. If no query, just render with dimmed date prefix
-  if (!query || !*query) {
-    // Check for date prefix and render with dimming
-    if (has_date_prefix(text)) {
-      // Render date prefix (YYYY-MM-DD-) with dark color, including the trailing dash
-      tui_push(&ss, TUI_DARK);
-      zstr_cat_len(&entry->rendered, text, 11); // Date + dash is 11 chars
-      tui_pop(&ss);
-      zstr_cat(&entry->rendered, text + 11); // Rest after dash
-    } else {
-      zstr_cat(&entry->rendered, text);
-    }
-    // Time-based scoring (matches Ruby reference)
-    time_t now = time(NULL);
-    double hours_since_access = difftime(now, entry->mtime) / 3600.0;
-    entry->score += 3.0 / sqrt(hours_since_access + 1);
-    return;
+static void mask_begin(EntryStore *store, size_t text_len, MatchMask *m) {
+  m->inline_mask = 0;
+  m->words = &m->inline_mask;
+  m->spill_at = store->match_spill.length;
+  m->spilled = text_len > ENTRY_MATCH_INLINE;
+  if (m->spilled) {
+    size_t words = (text_len + 63) / 64;
+    vec_reserve_u64(&store->match_spill, m->spill_at + words);
+    m->words = store->match_spill.data + m->spill_at;
+    memset(m->words, 0, words * sizeof(uint64_t));
+    store->match_spill.length = m->spill_at + words;
   }
+}
 
-  // 3. Fuzzy match with highlighting
-  // We need lower-case versions for case-insensitive matching
-  Z_CLEANUP(zstr_free) zstr text_lower = zstr_from(text);
-  Z_CLEANUP(zstr_free) zstr query_lower = zstr_from(query);
-
-  // In-place tolower
-  char *text_data = zstr_data(&text_lower);
-  char *query_data = zstr_data(&query_lower);
-  for (size_t i = 0; i < zstr_len(&text_lower); i++)
-    text_data[i] = tolower(text_data[i]);
-  for (size_t i = 0; i < zstr_len(&query_lower); i++)
-    query_data[i] = tolower(query_data[i]);
+static void mask_commit(EntryStore *store, size_t idx, const MatchMask *m) {
+  store->match.data[idx] = m->spilled ? m->spill_at : m->inline_mask;
+}
 
-  const char *t_ptr = text_data;
-  const char *q_ptr = query_data;
-  const char *orig_ptr = text;
+static void mask_drop(EntryStore *store, const MatchMask *m) {
+  store->match_spill.length = m->spill_at;
+}
 
-  int query_len = zstr_len(&query_lower);
-  int query_idx = 0;
-  int last_pos = -1;
-  int current_pos = 0;
-  bool has_date = has_date_prefix(text);
-  bool in_date_section = false;
-
-  // Track fuzzy match score separately
-  float fuzzy_score = 0.0;
-
-  while (*t_ptr) {
-    // Handle date prefix dimming (including the trailing dash at position 10)
-    if (has_date && current_pos == 0) {
-      tui_push(&ss, TUI_DARK);
-      in_date_section = true;
-    }
+static void mask_range(uint64_t *mask, size_t start, size_t len) {
+  for (size_t pos = start; pos < start + len; pos++)
+    mask[pos >> 6] |= 1ULL << (pos & 63);
+}
 
-    if (query_idx < query_len && *t_ptr == q_ptr[query_idx]) {
-      // Match found!
-      fuzzy_score += 1.0;
+// Where the greedy scan can start: a date prefix is only digits and dashes,
+// so a query starting with anything else can't match inside it
+static int scan_start(const EntryStore *store, size_t idx, zstr_view query_lower) {
+  char first = query_lower.data[0];
+  if (entry_date(store, idx) == 0 || isdigit((unsigned char)first) || first == '-')
+    return 0;
+  return ENTRY_DATE_PREFIX_LEN;
+}
 
-      // Word boundary bonus
-      if (current_pos == 0 || !isalnum(*(t_ptr - 1))) {
-        fuzzy_score += 1.0;
-      }
+// Greedy scores are summed in 16.16 fixed point: per matched character 1,
+// +1 on a word boundary (from the entry's precomputed bits) and the
+// proximity bonus 2/sqrt(gap+1), read from a table for gaps the alignment
+// search also covers. Table: round(2 / sqrt(gap + 1) * 65536).
+#define FIXED_ONE 65536
+#define PROX_TABLE_SIZE 256
 
-      // Proximity bonus (bumped to favor consecutive matches)
-      if (last_pos >= 0) {
-        int gap = current_pos - last_pos - 1;
-        fuzzy_score += 2.0 / sqrt(gap + 1);
-      }
+static const uint32_t prox_table[PROX_TABLE_SIZE] = {
+  131072,  92682,  75674,  65536,  58617,  53510,  49541,  46341,
+   43691,  41449,  39520,  37837,  36353,  35030,  33843,  32768,
+   31790,  30894,  30070,  29309,  28602,  27945,  27330,  26755,
+   26214,  25705,  25225,  24770,  24339,  23930,  23541,  23170,
+   22817,  22479,  22155,  21845,  21548,  21263,  20988,  20724,
+   20470,  20225,  19988,  19760,  19539,  19326,  19119,  18919,
+   18725,  18536,  18354,  18176,  18004,  17837,  17674,  17515,
+   17361,  17211,  17064,  16921,  16782,  16646,  16514,  16384,
+   16257,  16134,  16013,  15895,  15779,  15666,  15555,  15447,
+   15341,  15237,  15135,  15035,  14937,  14841,  14747,  14654,
+   14564,  14474,  14387,  14301,  14217,  14134,  14052,  13972,
+   13894,  13816,  13740,  13665,  13592,  13519,  13448,  13377,
+   13308,  13240,  13173,  13107,  13042,  12978,  12915,  12853,
+   12791,  12731,  12671,  12612,  12554,  12497,  12441,  12385,
+   12330,  12276,  12223,  12170,  12118,  12066,  12015,  11965,
+   11916,  11867,  11818,  11771,  11723,  11677,  11631,  11585,
+   11540,  11496,  11452,  11408,  11365,  11323,  11281,  11239,
+   11198,  11158,  11117,  11078,  11038,  10999,  10961,  10923,
+   10885,  10848,  10811,  10774,  10738,  10702,  10666,  10631,
+   10597,  10562,  10528,  10494,  10461,  10428,  10395,  10362,
+   10330,  10298,  10266,  10235,  10204,  10173,  10143,  10112,
+   10082,  10053,  10023,   9994,   9965,   9937,   9908,   9880,
+    9852,   9824,   9797,   9770,   9743,   9716,   9689,   9663,
+    9637,   9611,   9585,   9559,   9534,   9509,   9484,   9459,
+    9435,   9410,   9386,   9362,   9338,   9315,   9291,   9268,
+    9245,   9222,   9199,   9177,   9154,   9132,   9110,   9088,
+    9066,   9045,   9023,   9002,   8981,   8960,   8939,   8918,
+    8898,   8877,   8857,   8837,   8817,   8797,   8777,   8758,
+    8738,   8719,   8700,   8680,   8661,   8643,   8624,   8605,
+    8587,   8568,   8550,   8532,   8514,   8496,   8478,   8461,
+    8443,   8426,   8408,   8391,   8374,   8357,   8340,   8323,
+    8306,   8290,   8273,   8257,   8240,   8224,   8208,   8192,
+};
 
-      last_pos = current_pos;
-      query_idx++;
+static uint32_t prox_fixed(int gap) {
+  if (gap < PROX_TABLE_SIZE)
+    return prox_table[gap];
+  return (uint32_t)(2.0 / sqrt(gap + 1) * FIXED_ONE + 0.5);
+}
 
-      // Append highlighted char (yellow fg, preserves dark if in date section)
-      tui_push(&ss, TUI_MATCH);
-      tui_putc(&ss, *orig_ptr);
-      tui_pop(&ss);
-    } else {
-      // No match, append regular char
-      tui_putc(&ss, *orig_ptr);
-    }
+// Greedy fuzzy match of a query in entry idx's lowercase name from `start`,
+// marking the matched positions. Returns the match score before the date
+// and contextual bonuses, or a negative value if the name doesn't contain
+// the query.
+//
+// The scan jumps straight to the next occurrence of each query character
+// with memchr() instead of comparing byte by byte.
+static float greedy_match(const EntryStore *store, size_t idx, int start,
+                          zstr_view query_lower, uint64_t *mask) {
+  zstr_view name = entry_lower_view(store, idx);
+  const char *text = name.data;
+  const char *end = text + name.len;
+  const char *at = text + start;
+  size_t query_len = query_lower.len;
+  int last_pos = -1;
+  uint32_t fixed = 0;
 
-    // Close dim section after the trailing dash (position 10)
-    if (has_date && current_pos == 10 && in_date_section) {
-      tui_pop(&ss);
-      in_date_section = false;
-    }
+  for (size_t query_idx = 0; query_idx < query_len; query_idx++) {
+    const char *found = memchr(at, query_lower.data[query_idx], (size_t)(end - at));
+    // If we didn't match the full query, filter out
+    if (!found)
+      return -1.0;
 
-    t_ptr++;
-    orig_ptr++;
-    current_pos++;
-  }
+    // Match found: character, word boundary and (after the first match)
+    // proximity bonuses, without branching on any of them
+    int pos = (int)(found - text);
+    mask[pos >> 6] |= 1ULL << (pos & 63);
+    uint32_t boundary = entry_word_start(store, idx, (size_t)pos);
+    uint32_t follows = last_pos >= 0;
+    fixed += FIXED_ONE + boundary * FIXED_ONE + follows * prox_fixed(pos - last_pos - 1);
 
-  // If we didn't match the full query, score is 0 (filter out)
-  if (query_idx < query_len) {
-    entry->score = 0.0;
-    // Keep the rendered string as is (it will be filtered out anyway)
-    return;
+    last_pos = pos;
+    at = found + 1;
   }
 
   // Apply multipliers only to fuzzy match score
+  float fuzzy_score = (float)fixed / FIXED_ONE;
+
   // Density bonus
   if (last_pos >= 0) {
     fuzzy_score *= ((float)query_len / (last_pos + 1));
   }
 
   // Length penalty
-  int text_len = zstr_len(&entry->name);
-  fuzzy_score *= (10.0 / (text_len + 10.0));
+  fuzzy_score *= (10.0 / (name.len + 10.0));
+  return fuzzy_score;
+}
+
+float fuzzy_score(EntryStore *store, size_t idx, zstr_view query_lower) {
+  // Contextual bonuses: last activity and access frequency
+  float recency = store->recency.data[idx] + store->frecency.data[idx];
+
+  // No query: time-based scoring only
+  if (query_lower.len == 0)
+    return recency;
+
+  zstr_view name = entry_lower_view(store, idx);
+  MatchMask mask;
+  mask_begin(store, name.len, &mask);
+  float fuzzy_score = greedy_match(store, idx, scan_start(store, idx, query_lower),
+                                   query_lower, mask.words);
+
+  // If we didn't match the full query, score is 0 (filter out)
+  if (fuzzy_score < 0) {
+    mask_drop(store, &mask);
+    return 0.0;
+  }
+  mask_commit(store, idx, &mask);
 
   // Date prefix bonus (applied after multipliers to avoid crushing)
   float date_bonus = 0.0;
-  if (has_date_prefix(text)) {
+  if (entry_date(store, idx) != 0) {
     date_bonus = 2.0;
   }
 
   // Now add contextual bonuses (not affected by multipliers)
-  entry->score = fuzzy_score + date_bonus;
+  return fuzzy_score + date_bonus + recency;
+}
 
-  // Time-based scoring (matches Ruby reference implementation)
-  time_t now = time(NULL);
+// ============================================================================
+// Query syntax
+// ============================================================================
 
-  // Access time bonus - recently accessed is better
-  double hours_since_access = difftime(now, entry->mtime) / 3600.0;
-  entry->score += 3.0 / sqrt(hours_since_access + 1);
+// Cheapest terms first, so most names are rejected before a fuzzy scan
+static int term_cost(const FuzzyTerm *t) {
+  switch (t->kind) {
+  case TERM_DATE:
+  case TERM_AGE:
+    return 0;
+  case TERM_EQUAL:
+  case TERM_PREFIX:
+  case TERM_SUFFIX:
+    return 1;
+  case TERM_EXACT:
+    return 2;
+  default:
+    return 3;
+  }
 }
 
-float calculate_score(const char *text, const char *query, time_t mtime) {
-  // Convenience wrapper using the new logic
-  // We create a temporary entry just for scoring
-  TryEntry tmp = {0};
-  tmp.name = zstr_from(text);
-  tmp.rendered = zstr_init();
-  tmp.path = zstr_init();
-  tmp.mtime = mtime;
+static uint32_t date_of(time_t t) {
+  struct tm tm;
+  localtime_r(&t, &tm);
+  return (uint32_t)(tm.tm_year + 1900) * 10000 + (uint32_t)(tm.tm_mon + 1) * 100 +
+         (uint32_t)tm.tm_mday;
+}
+
+// Parses the part of a date term after '@' into a range of YYYYMMDD dates:
+// "2025", "2025-11" or "2025-11-03", or "<30d" / ">2w" for names dated
+// within / before that many days or weeks of now
+static bool parse_date_term(FuzzyTerm *t, const char *s, size_t len, time_t now) {
+  if (len >= 3 && (s[0] == '<' || s[0] == '>')) {
+    uint32_t n = 0;
+    size_t i = 1;
+    for (; i < len && isdigit((unsigned char)s[i]) && n < 100000; i++)
+      n = n * 10 + (uint32_t)(s[i] - '0');
+    if (i == 1 || i + 1 != len || (s[i] != 'd' && s[i] != 'w'))
+      return false;
+    uint32_t cutoff = date_of(now - (time_t)n * (s[i] == 'w' ? 7 : 1) * 86400);
+    t->kind = TERM_AGE;
+    t->lo = s[0] == '<' ? cutoff : 1;
+    t->hi = s[0] == '<' ? UINT32_MAX : cutoff - 1;
+    return true;
+  }
+
+  // Each missing field widens the range by its digits
+  static const char layout[] = "dddd-dd-dd";
+  if (len != 4 && len != 7 && len != 10)
+    return false;
+  uint32_t date = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (layout[i] == '-' ? s[i] != '-' : !isdigit((unsigned char)s[i]))
+      return false;
+    if (layout[i] != '-')
+      date = date * 10 + (uint32_t)(s[i] - '0');
+  }
+  uint32_t span = len == 4 ? 10000 : len == 7 ? 100 : 1;
+  t->kind = TERM_DATE;
+  t->lo = date * span;
+  t->hi = t->lo + span - 1;
+  t->lo = t->lo > 0 ? t->lo : 1;  // 0 is "no date"
+  return true;
+}
+
+static void add_term(FuzzyQuery *q, const char *token, size_t len, time_t now) {
+  FuzzyTerm t = {.kind = TERM_FUZZY};
+  if (len > 0 && token[0] == '!') {
+    t.negate = true;
+    token++, len--;
+  }
+  if (len > 0 && token[0] == '@') {
+    // Incomplete dates filter nothing until they parse
+    token++, len--;
+    if (!parse_date_term(&t, token, len, now))
+      return;
+  } else if (len > 0 && token[0] == '\'') {
+    t.kind = TERM_EXACT;
+    token++, len--;
+  } else if (len > 0 && token[0] == '^') {
+    t.kind = TERM_PREFIX;
+    token++, len--;
+    if (len > 0 && token[len - 1] == '$') {
+      t.kind = TERM_EQUAL;
+      len--;
+    }
+  } else if (len > 0 && token[len - 1] == '$') {
+    t.kind = TERM_SUFFIX;
+    len--;
+  } else if (t.negate) {
+    // "!foo" excludes names containing foo, as in fzf
+    t.kind = TERM_EXACT;
+  }
+
+  // A lone operator (still being typed) filters nothing
+  if (len == 0 || q->count >= FUZZY_MAX_TERMS)
+    return;
+  t.text = (zstr_view){token, len};
+
+  size_t at = q->count++;
+  while (at > 0 && term_cost(&q->terms[at - 1]) > term_cost(&t)) {
+    q->terms[at] = q->terms[at - 1];
+    at--;
+  }
+  q->terms[at] = t;
+  if (t.negate)
+    return;
+  if (t.kind == TERM_DATE || t.kind == TERM_AGE) {
+    q->date_lo = t.lo > q->date_lo ? t.lo : q->date_lo;
+    q->date_hi = t.hi < q->date_hi ? t.hi : q->date_hi;
+    q->dated = true;
+  } else {
+    zstr_cat_len(&q->required, token, len);
+  }
+}
+
+void fuzzy_query_parse(FuzzyQuery *q, const char *input, time_t now) {
+  *q = (FuzzyQuery){.lower = zstr_from(input ? input : ""),
+                    .required = zstr_init(),
+                    .date_hi = UINT32_MAX};
+  zstr_to_lower(&q->lower);
+
+  const char *s = zstr_cstr(&q->lower);
+  size_t len = zstr_len(&q->lower);
+  for (size_t i = 0; i < len;) {
+    while (i < len && s[i] == ' ')
+      i++;
+    size_t start = i;
+    while (i < len && s[i] != ' ')
+      i++;
+    if (i > start)
+      add_term(q, s + start, i - start, now);
+  }
+}
+
+void fuzzy_query_free(FuzzyQuery *q) {
+  zstr_free(&q->lower);
+  zstr_free(&q->required);
+  q->count = 0;
+}
+
+zstr_view fuzzy_query_plain(const FuzzyQuery *q) {
+  if (q->count == 1 && q->terms[0].kind == TERM_FUZZY && !q->terms[0].negate)
+    return q->terms[0].text;
+  return (zstr_view){"", 0};
+}
+
+float fuzzy_query_score(EntryStore *store, size_t idx, const FuzzyQuery *q) {
+  zstr_view plain = fuzzy_query_plain(q);
+  if (q->count <= 1 && (q->count == 0 || plain.len > 0))
+    return fuzzy_score(store, idx, plain);
+
+  zstr_view name = entry_lower_view(store, idx);
+  const char *text = name.data;
+  size_t text_len = name.len;
+
+  MatchMask mask;
+  mask_begin(store, text_len, &mask);
+  float total = 0.0f;
+  for (size_t i = 0; i < q->count; i++) {
+    const FuzzyTerm *t = &q->terms[i];
+    const char *word = t->text.data;
+    size_t n = t->text.len;
+    bool hit = false;
+    size_t at = 0;
+
+    switch (t->kind) {
+    case TERM_DATE:
+    case TERM_AGE:
+      hit = entry_date(store, idx) >= t->lo && entry_date(store, idx) <= t->hi;
+      break;
+    case TERM_EQUAL:
+      hit = text_len == n && memcmp(text, word, n) == 0;
+      break;
+    case TERM_PREFIX:
+      hit = text_len >= n && memcmp(text, word, n) == 0;
+      break;
+    case TERM_SUFFIX:
+      at = text_len - n;
+      hit = text_len >= n && memcmp(text + at, word, n) == 0;
+      break;
+    case TERM_EXACT: {
+      const char *found = simd_find(text, text_len, word, n);
+      hit = found != NULL;
+      at = hit ? (size_t)(found - text) : 0;
+      break;
+    }
+    default: {
+      float score = greedy_match(store, idx, scan_start(store, idx, t->text), t->text,
+                                 mask.words);
+      hit = score >= 0;
+      total += hit ? score : 0.0f;
+      break;
+    }
+    }
+
+    if (hit == t->negate) {
+      mask_drop(store, &mask);
+      return 0.0f;
+    }
+    // Filter terms add a flat point: their matches rank by the fuzzy terms
+    // and recency
+    if (t->kind != TERM_FUZZY && !t->negate) {
+      if (t->kind != TERM_AGE)
+        mask_range(mask.words, at, n);
+      total += 1.0f;
+    }
+  }
+  mask_commit(store, idx, &mask);
+
+  float date_bonus = entry_date(store, idx) != 0 ? 2.0f : 0.0f;
+  return total + date_bonus + store->recency.data[idx] + store->frecency.data[idx];
+}
+
+// ============================================================================
+// Optimal alignment
+// ============================================================================
+//
+// The greedy pass takes the first occurrence of every query character, so
+// "pool" against "2025-01-02-postgres-connection-pool" matches p-o-(o)-l
+// scattered over the name rather than the word at its end. The rescoring
+// pass maximizes the same score over every alignment:
+//
+//   row[j][p] = base[j][p] + max over p' < p of (row[j-1][p'] + 2/sqrt(p-p'))
+//
+// where base[j][p] is the per-character score (1, +1 on a word boundary)
+// if name character p is query character j, and a large negative value
+// otherwise. The density multiplier only depends on the last position, so
+// it's applied to the last row.
+//
+// Predecessors up to DP_BAND characters back are exact; farther ones use
+// the best value of the row so far, which still yields a real alignment.
+// The banded part runs over fixed-size chunks of a row for one distance at
+// a time with no branches, so compilers turn it into SIMD max/add. Rows are
+// padded with DP_BAND empty cells in front so p - d never goes negative.
+
+#define DP_BAND 16
+#define DP_CHUNK 8
+#define DP_NONE -1e30f
+#define DP_ROW (DP_BAND + FUZZY_DP_MAX_TEXT)
+
+// out[p] = max(out[p], in[p] + bonus) over whole chunks
+static void dp_max_shifted(float *restrict out, const float *restrict in,
+                           size_t chunks, float bonus) {
+  for (size_t c = 0; c < chunks; c++) {
+    for (int k = 0; k < DP_CHUNK; k++) {
+      float v = in[c * DP_CHUNK + k] + bonus;
+      out[c * DP_CHUNK + k] = v > out[c * DP_CHUNK + k] ? v : out[c * DP_CHUNK + k];
+    }
+  }
+}
+
+// Best predecessor of position p, as computed for row[j][p]: the banded
+// maximum, or the best value farther back if that's higher
+static size_t dp_predecessor(const float *prev, size_t p, const float *prox) {
+  float best = DP_NONE * 2;
+  size_t best_at = 0;
+  for (size_t d = 1; d <= DP_BAND && d <= p; d++) {
+    if (prev[p - d] + prox[d] > best) {
+      best = prev[p - d] + prox[d];
+      best_at = p - d;
+    }
+  }
+  if (p > DP_BAND) {
+    size_t far_at = 0;
+    for (size_t q = 1; q + DP_BAND < p; q++) {
+      if (prev[q] > prev[far_at])
+        far_at = q;
+    }
+    if (prev[far_at] + 2.0f / sqrtf((float)(p - far_at)) > best)
+      best_at = far_at;
+  }
+  return best_at;
+}
+
+float fuzzy_rescore(EntryStore *store, size_t idx, zstr_view query_lower) {
+  float greedy = store->score.data[idx];
+  zstr_view name = entry_lower_view(store, idx);
+  const char *text = name.data;
+  size_t n = name.len;
+  size_t m = query_lower.len;
+  if (m == 0 || m > FUZZY_DP_MAX_QUERY || n > FUZZY_DP_MAX_TEXT || greedy <= 0.0f)
+    return greedy;
+
+  size_t chunks = (n + DP_CHUNK - 1) / DP_CHUNK;
+  size_t padded = chunks * DP_CHUNK;
+
+  float prox[DP_BAND + 1];
+  for (int d = 1; d <= DP_BAND; d++)
+    prox[d] = 2.0f / sqrtf((float)d);
+
+  float boundary[FUZZY_DP_MAX_TEXT];
+  for (size_t p = 0; p < n; p++)
+    boundary[p] = entry_word_start(store, idx, p) ? 2.0f : 1.0f;
+
+  // rows[j] + DP_BAND is row j; the cells in front stay DP_NONE
+  static _Thread_local float rows[FUZZY_DP_MAX_QUERY][DP_ROW];
+  float base[FUZZY_DP_MAX_TEXT];
+
+  for (size_t j = 0; j < m; j++) {
+    float *row = rows[j] + DP_BAND;
+    const float *prev = rows[j > 0 ? j - 1 : 0] + DP_BAND;
+    char qc = query_lower.data[j];
+
+    for (size_t p = 0; p < padded; p++)
+      base[p] = p < n && text[p] == qc ? boundary[p] : DP_NONE;
+    for (size_t p = 0; p < DP_BAND; p++)
+      rows[j][p] = DP_NONE;
+
+    if (j == 0) {
+      memcpy(row, base, padded * sizeof(float));
+      continue;
+    }
+
+    for (size_t p = 0; p < padded; p++)
+      row[p] = DP_NONE * 2;
+
+    // Banded part: exact for predecessors up to DP_BAND characters back
+    for (size_t d = 1; d <= DP_BAND; d++)
+      dp_max_shifted(row, prev - d, chunks, prox[d]);
+
+    // Farther predecessors: the best one so far
+    size_t far_at = 0;
+    for (size_t p = DP_BAND + 1; p < n; p++) {
+      size_t q = p - DP_BAND - 1;
+      if (prev[q] > prev[far_at])
+        far_at = q;
+      float v = prev[far_at] + 2.0f / sqrtf((float)(p - far_at));
+      row[p] = v > row[p] ? v : row[p];
+    }
+
+    for (size_t c = 0; c < chunks; c++) {
+      float *out = row + c * DP_CHUNK;
+      const float *add = base + c * DP_CHUNK;
+      for (int k = 0; k < DP_CHUNK; k++)
+        out[k] += add[k];
+    }
+  }
+
+  // Density bonus on the last row
+  const float *last = rows[m - 1] + DP_BAND;
+  float best = DP_NONE;
+  size_t best_at = 0;
+  for (size_t p = 0; p < n; p++) {
+    if (last[p] <= DP_NONE / 2)
+      continue;
+    float dense = last[p] * ((float)m / (float)(p + 1));
+    if (dense > best) {
+      best = dense;
+      best_at = p;
+    }
+  }
+  if (best <= DP_NONE / 2)
+    return greedy;
 
-  fuzzy_match(&tmp, query);
+  float score = best * (10.0f / ((float)n + 10.0f));
+  if (entry_date(store, idx) != 0)
+    score += 2.0f;
+  score += store->recency.data[idx] + store->frecency.data[idx];
+  if (score <= greedy)
+    return greedy;
 
-  float score = tmp.score;
+  // Trace the alignment back into the match mask
+  uint64_t inline_mask = 0;
+  uint64_t *mask = n > ENTRY_MATCH_INLINE
+                       ? store->match_spill.data + store->match.data[idx]
+                       : &inline_mask;
+  if (n > ENTRY_MATCH_INLINE)
+    memset(mask, 0, ((n + 63) / 64) * sizeof(uint64_t));
+  size_t pos = best_at;
+  for (size_t j = m; j-- > 0;) {
+    mask[pos >> 6] |= 1ULL << (pos & 63);
+    if (j > 0)
+      pos = dp_predecessor(rows[j - 1] + DP_BAND, pos, prox);
+  }
+  if (n <= ENTRY_MATCH_INLINE)
+    store->match.data[idx] = inline_mask;
+
+  store->score.data[idx] = score;
+  return score;
+}
+
+// ============================================================================
+// Typo fallback
+// ============================================================================
+
+bool fuzzy_typo_init(FuzzyTypo *typo, zstr_view query_lower) {
+  if (query_lower.len < FUZZY_TYPO_MIN_QUERY || query_lower.len > 64)
+    return false;
+
+  memset(typo->peq, 0, sizeof(typo->peq));
+  for (size_t i = 0; i < query_lower.len; i++)
+    typo->peq[(unsigned char)query_lower.data[i]] |= 1ULL << i;
+  simd_charset_init(&typo->chars, query_lower.data, query_lower.len);
+  typo->last = 1ULL << (query_lower.len - 1);
+  typo->len = (int)query_lower.len;
+  typo->max_edits = query_lower.len >= 8 ? 2 : 1;
+  return true;
+}
+
+int fuzzy_typo_match(const FuzzyTypo *typo, EntryStore *store, size_t idx) {
+  zstr_view name = entry_lower_view(store, idx);
+  const unsigned char *text = (const unsigned char *)name.data;
+
+  // Every query character missing from the name costs an edit: most names
+  // are ruled out by this before the (serially dependent) edit distance
+  uint64_t all = typo->chars.count == 64 ? ~0ULL : (1ULL << typo->chars.count) - 1;
+  uint64_t found = simd_charset_scan(&typo->chars, name.data, name.len);
+  if (__builtin_popcountll(all & ~found) > typo->max_edits)
+    return -1;
+
+  // Column of the DP matrix as vertical +1/-1 deltas. The top row stays 0,
+  // so a match may start anywhere in the name (no carry into bit 0).
+  uint64_t pv = ~0ULL;
+  uint64_t mv = 0;
+  int dist = typo->len;
+  int best = dist;
+  for (size_t i = 0; i < name.len; i++) {
+    uint64_t eq = typo->peq[text[i]];
+    uint64_t xv = eq | mv;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    dist += (int)((ph & typo->last) != 0) - (int)((mh & typo->last) != 0);
+    ph <<= 1;
+    mh <<= 1;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    best = dist < best ? dist : best;
+  }
+  if (best > typo->max_edits)
+    return -1;
+
+  if (name.len <= ENTRY_MATCH_INLINE) {
+    store->match.data[idx] = 0;
+  } else {
+    size_t words = (name.len + 63) / 64;
+    store->match.data[idx] = store->match_spill.length;
+    for (size_t w = 0; w < words; w++)
+      vec_push_u64(&store->match_spill, 0);
+  }
+  return best;
+}
+
+void fuzzy_paint(TuiStyleString *ss, const EntryStore *store, size_t idx,
+                 bool highlight) {
+  zstr_view name = entry_name_view(store, idx);
+  const char *text = name.data;
+  size_t text_len = name.len;
+  bool has_date = entry_date(store, idx) != 0;
+
+  // No query: just render with dimmed date prefix
+  if (!highlight) {
+    if (has_date) {
+      // Date + dash is 11 chars
+      tui_print_view(ss, TUI_DARK, zstr_sub(name, 0, ENTRY_DATE_PREFIX_LEN));
+      tui_print_view(ss, NULL, zstr_sub(name, ENTRY_DATE_PREFIX_LEN,
+                                        text_len - ENTRY_DATE_PREFIX_LEN));
+    } else {
+      tui_print_view(ss, NULL, name);
+    }
+    return;
+  }
+
+  const uint64_t *mask = entry_match_mask(store, idx);
+  for (size_t pos = 0; pos < text_len; pos++) {
+    // Dim the date prefix, including the trailing dash at position 10
+    if (has_date && pos == 0)
+      tui_push(ss, TUI_DARK);
+
+    if (mask[pos >> 6] & (1ULL << (pos & 63))) {
+      // Append highlighted char (yellow fg, preserves dark if in date section)
+      tui_push(ss, TUI_MATCH);
+      tui_putc(ss, text[pos]);
+      tui_pop(ss);
+    } else {
+      tui_putc(ss, text[pos]);
+    }
+
+    if (has_date && pos == 10)
+      tui_pop(ss);
+  }
+}
+
+void fuzzy_match(EntryStore *store, size_t idx, zstr_view query) {
+  Z_CLEANUP(zstr_free) zstr query_lower = zstr_from_view(query);
+  zstr_to_lower(&query_lower);
+
+  store->score.data[idx] = fuzzy_score(store, idx, zstr_as_view(&query_lower));
+}
+
+float calculate_score(const char *text, const char *query, time_t mtime) {
+  // Convenience wrapper: score through a temporary one-entry store
+  EntryStore tmp;
+  entry_store_init(&tmp, "", time(NULL));
+  size_t idx = entry_store_push(&tmp, zstr_view_from(text), mtime);
 
-  zstr_free(&tmp.name);
-  zstr_free(&tmp.rendered);
-  zstr_free(&tmp.path);
+  Z_CLEANUP(zstr_free) zstr query_lower = zstr_from(query ? query : "");
+  zstr_to_lower(&query_lower);
+  float score = fuzzy_score(&tmp, idx, zstr_as_view(&query_lower));
 
+  entry_store_free(&tmp);
   return score;
 }
@@ -1,12 +1,135 @@
 #ifndef FUZZY_H
 #define FUZZY_H
 
-#include "tui.h" // Need full definition of TryEntry
+#include "entries.h"
+#include "simd.h"
+#include "tui_style.h"
+#include <stddef.h>
 #include <time.h>
 
-// Updates entry->score and entry->rendered in-place
-// Rendered string contains ANSI codes for highlighting matched characters
-void fuzzy_match(TryEntry *entry, const char *query);
+// Forgets the match positions of the previous query. Call before scoring
+// the store against a new one.
+void fuzzy_reset_matches(EntryStore *store);
+
+// Scores entry `idx` against an already-lowercased query and records the
+// matched positions (see entry_match_mask()).
+// Reads only the store's hot columns (lowercase names, recency bonuses).
+// Returns <= 0 when a non-empty query doesn't match.
+float fuzzy_score(EntryStore *store, size_t idx, zstr_view query_lower);
+
+// ============================================================================
+// Query syntax
+// ============================================================================
+//
+// The filter input is a list of space-separated terms, all of which must
+// match (fzf syntax):
+//
+//   foo      fuzzy match
+//   'foo     contains foo
+//   ^foo     starts with foo        ^foo$  is exactly foo
+//   foo$     ends with foo
+//   !foo     doesn't contain foo    (also !^foo, !foo$, !'foo)
+//   @2025-11 dated in November 2025 (also @2025, @2025-11-03)
+//   @<30d    dated within the last 30 days (also @>30d, @<2w)
+//
+// Terms are evaluated cheapest first (date compares, prefix/suffix compares,
+// then substring search, then fuzzy scans) and the first one that fails rejects the name.
+// A single plain term is the common case and goes straight to fuzzy_score().
+
+#define FUZZY_MAX_TERMS 16
+
+typedef enum {
+  TERM_FUZZY,
+  TERM_EXACT,
+  TERM_PREFIX,
+  TERM_SUFFIX,
+  TERM_EQUAL,
+  TERM_DATE,
+  TERM_AGE,
+} FuzzyTermKind;
+
+typedef struct {
+  uint8_t kind;        // FuzzyTermKind
+  bool negate;
+  zstr_view text;      // Into FuzzyQuery.lower
+  uint32_t lo, hi;     // Date terms: range of YYYYMMDD entry dates
+} FuzzyTerm;
+
+typedef struct {
+  zstr lower;          // Lowercased input
+  FuzzyTerm terms[FUZZY_MAX_TERMS];  // Cheapest first
+  size_t count;
+  zstr required;       // Characters of the positive terms (see postings.h)
+  bool dated;          // Positive date terms limit matches to date_lo..hi
+  uint32_t date_lo, date_hi;
+} FuzzyQuery;
+
+// `now` anchors relative dates (@<30d)
+void fuzzy_query_parse(FuzzyQuery *q, const char *input, time_t now);
+void fuzzy_query_free(FuzzyQuery *q);
+
+// The query's only term when it's a plain fuzzy one (which also gets
+// rescoring and the typo fallback), or an empty view
+zstr_view fuzzy_query_plain(const FuzzyQuery *q);
+
+// Scores an entry against every term, recording the matched positions of
+// the positive ones. Fuzzy terms add their match scores, other positive
+// terms a flat point. Returns <= 0 when a term rejects the name.
+float fuzzy_query_score(EntryStore *store, size_t idx, const FuzzyQuery *q);
+
+// Limits of the alignment search; longer queries or names keep their
+// greedy score
+#define FUZZY_DP_MAX_QUERY 32
+#define FUZZY_DP_MAX_TEXT 256
+
+// Candidates per query that get the alignment search
+#define FUZZY_RESCORE_TOP 100
+
+// Rescores an entry that matched fuzzy_score() with the best alignment of
+// the query rather than the greedy one, updating its score and match
+// positions when that scores higher. Much costlier than fuzzy_score(), so
+// meant for the top candidates only. Returns the (possibly unchanged) score.
+float fuzzy_rescore(EntryStore *store, size_t idx, zstr_view query_lower);
+
+// ============================================================================
+// Typo fallback
+// ============================================================================
+//
+// When a query has a typo the fuzzy pass matches nothing useful, so names
+// whose closest substring is within a few edits of the query are offered
+// below the real matches. Myers' bit-parallel algorithm keeps the whole
+// query in one 64-bit word and needs a handful of word operations per name
+// character.
+
+#define FUZZY_TYPO_MIN_QUERY 5    // Shorter queries get no fallback: one edit
+                                  // away from some substring of almost any name
+#define FUZZY_TYPO_MAX_EDITS 2
+#define FUZZY_TYPO_RESULTS 5      // Fallback runs below this many matches
+
+typedef struct {
+  uint64_t peq[256];   // Query positions of each byte
+  SimdCharset chars;   // Distinct bytes of the query
+  uint64_t last;       // Bit of the query's last character
+  int len;
+  int max_edits;       // 1, or 2 for queries of 8+ characters
+} FuzzyTypo;
+
+// Prepares the fallback for an already-lowercased query. Returns false if
+// the query is too short or too long (over 64 bytes) for it.
+bool fuzzy_typo_init(FuzzyTypo *typo, zstr_view query_lower);
+
+// Edit distance between the query and the closest substring of the entry's
+// name, or -1 if it's above typo->max_edits. On a hit the entry's match
+// positions are cleared, so painting it highlights nothing.
+int fuzzy_typo_match(const FuzzyTypo *typo, EntryStore *store, size_t idx);
+
+// Appends the entry's name to a row: dimmed date prefix and, when
+// `highlight` is set, the positions matched by the last query
+void fuzzy_paint(TuiStyleString *ss, const EntryStore *store, size_t idx,
+                 bool highlight);
+
+// Updates the score and match positions of entry `idx` in-place
+void fuzzy_match(EntryStore *store, size_t idx, zstr_view query);
 
 // Legacy/Convenience: just calculate score (read-only)
 float calculate_score(const char *text, const char *query, time_t mtime);
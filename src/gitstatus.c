@@ -0,0 +1,434 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "gitstatus.h"
+#include "utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NO_ENTRY UINT32_MAX
+
+typedef struct {
+  uint32_t entry;
+  zstr path;           // Work tree to probe
+  EntryGit git;        // Cached badge in, fresh badge out
+} GitJob;
+
+Z_VEC_GENERATE_IMPL(GitJob, GitJob)
+
+struct GitStatus {
+  pthread_t thread;
+  bool started;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  bool stop;
+
+  // Guarded by lock
+  vec_GitJob queue;    // Pending probes, highest priority first
+  vec_GitJob results;  // Finished probes not yet polled
+  uint32_t current;    // Entry being probed, NO_ENTRY if idle
+  atomic_bool cancel;  // Abandon the current probe
+
+  vec_u32 visible;     // Rows of the last git_status_want() (caller's thread)
+};
+
+// ============================================================================
+// Native repository reading
+// ============================================================================
+
+// Reads a small file (HEAD, .git file) into buf. Returns bytes read or -1.
+static ssize_t read_small(const char *path, char *buf, size_t cap) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  ssize_t n = read(fd, buf, cap - 1);
+  close(fd);
+  if (n < 0)
+    return -1;
+  while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == '\r'))
+    n--;
+  buf[n] = '\0';
+  return n;
+}
+
+// Resolves the git directory of a work tree: a ".git" directory, or a
+// ".git" file pointing elsewhere ("gitdir: ..."), as `git worktree add`
+// and submodules create. Returns false if dir is not a work tree.
+static bool find_git_dir(const char *dir, zstr *git_dir) {
+  Z_CLEANUP(zstr_free) zstr dot_git = join_path(dir, ".git");
+  struct stat sb;
+  if (stat(zstr_cstr(&dot_git), &sb) != 0)
+    return false;
+
+  if (S_ISDIR(sb.st_mode)) {
+    *git_dir = zstr_dup(&dot_git);
+    return true;
+  }
+
+  char buf[4096];
+  if (read_small(zstr_cstr(&dot_git), buf, sizeof(buf)) <= 0 ||
+      strncmp(buf, "gitdir: ", 8) != 0)
+    return false;
+  const char *target = buf + 8;
+  *git_dir = target[0] == '/' ? zstr_from(target) : join_path(dir, target);
+  return true;
+}
+
+// Branch name from HEAD ("ref: refs/heads/<name>"), short id when detached
+static void read_head(const char *git_dir, char *branch, size_t cap) {
+  Z_CLEANUP(zstr_free) zstr path = join_path(git_dir, "HEAD");
+  char buf[512];
+  branch[0] = '\0';
+  if (read_small(zstr_cstr(&path), buf, sizeof(buf)) <= 0)
+    return;
+
+  const char *name = buf;
+  size_t len;
+  if (strncmp(buf, "ref: ", 5) == 0) {
+    name = buf + 5;
+    if (strncmp(name, "refs/heads/", 11) == 0)
+      name += 11;
+    len = strlen(name);
+  } else {
+    len = strlen(name) < 7 ? strlen(name) : 7;
+  }
+  if (len >= cap)
+    len = cap - 1;
+  memcpy(branch, name, len);
+  branch[len] = '\0';
+}
+
+static uint32_t be32(const unsigned char *p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint16_t be16(const unsigned char *p) {
+  return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+#define INDEX_ENTRY_FIXED 62       // Stat data, 20-byte object id, flags
+#define INDEX_FLAG_VALID 0x8000    // assume-unchanged
+#define INDEX_FLAG_EXTENDED 0x4000
+#define INDEX_FLAG_STAGE 0x3000
+#define INDEX_XFLAG_SKIP_WORKTREE 0x4000
+#define INDEX_XFLAG_INTENT_TO_ADD 0x2000
+#define INDEX_MODE_GITLINK 0160000
+
+// Walks the entries of a mapped index (versions 2-4), comparing the stat
+// data of each tracked file with the work tree. Returns GIT_CLEAN,
+// GIT_DIRTY, GIT_REPO if the index can't be parsed, or GIT_UNKNOWN if
+// cancelled.
+static GitState compare_index(const unsigned char *data, size_t len, int wtfd,
+                              atomic_bool *cancel) {
+  if (len < 12 || memcmp(data, "DIRC", 4) != 0)
+    return GIT_REPO;
+  uint32_t version = be32(data + 4);
+  uint32_t count = be32(data + 8);
+  if (version < 2 || version > 4)
+    return GIT_REPO;
+
+  char path[4096];
+  size_t path_len = 0;
+  size_t off = 12;
+  for (uint32_t i = 0; i < count; i++) {
+    if ((i & 255) == 0 && atomic_load(cancel))
+      return GIT_UNKNOWN;
+    if (off + INDEX_ENTRY_FIXED > len)
+      return GIT_REPO;
+
+    const unsigned char *e = data + off;
+    uint32_t mtime_sec = be32(e + 8);
+    uint32_t mtime_nsec = be32(e + 12);
+    uint32_t mode = be32(e + 24);
+    uint32_t size = be32(e + 36);
+    uint16_t flags = be16(e + 60);
+    uint16_t xflags = 0;
+    size_t hdr = INDEX_ENTRY_FIXED;
+    if (flags & INDEX_FLAG_EXTENDED) {
+      if (version < 3 || off + hdr + 2 > len)
+        return GIT_REPO;
+      xflags = be16(e + hdr);
+      hdr += 2;
+    }
+
+    // Path: plain and NUL-padded to 8 bytes (v2/v3), or prefix-compressed
+    // against the previous path (v4)
+    const unsigned char *name = e + hdr;
+    const unsigned char *end = data + len;
+    if (version == 4) {
+      size_t strip = 0;
+      unsigned char c;
+      do {
+        if (name >= end)
+          return GIT_REPO;
+        c = *name++;
+        strip = (strip << 7) | (c & 127);
+        if (c & 128)
+          strip++;
+      } while (c & 128);
+      if (strip > path_len)
+        return GIT_REPO;
+      path_len -= strip;
+    } else {
+      path_len = 0;
+    }
+    const unsigned char *nul = memchr(name, '\0', (size_t)(end - name));
+    if (!nul || path_len + (size_t)(nul - name) >= sizeof(path))
+      return GIT_REPO;
+    memcpy(path + path_len, name, (size_t)(nul - name));
+    path_len += (size_t)(nul - name);
+    path[path_len] = '\0';
+    if (version == 4) {
+      off = (size_t)(nul + 1 - data);
+    } else {
+      off += (hdr + (size_t)(nul - name) + 8) & ~(size_t)7;
+    }
+
+    if (flags & INDEX_FLAG_STAGE)
+      return GIT_DIRTY;  // Unmerged
+    if (xflags & INDEX_XFLAG_INTENT_TO_ADD)
+      return GIT_DIRTY;
+    if ((flags & INDEX_FLAG_VALID) || (xflags & INDEX_XFLAG_SKIP_WORKTREE))
+      continue;
+
+    struct stat sb;
+    if (fstatat(wtfd, path, &sb, AT_SYMLINK_NOFOLLOW) != 0)
+      return GIT_DIRTY;  // Deleted
+    if (mode == INDEX_MODE_GITLINK)
+      continue;          // Submodules have their own status
+    if ((uint32_t)sb.st_size != size || (uint32_t)sb.st_mtime != mtime_sec)
+      return GIT_DIRTY;
+    // Nanoseconds only count when both sides recorded them
+    if (mtime_nsec != 0 && STAT_MTIME_NSEC(sb) != 0 &&
+        (uint32_t)STAT_MTIME_NSEC(sb) != mtime_nsec)
+      return GIT_DIRTY;
+  }
+  return GIT_CLEAN;
+}
+
+// Probes one work tree. The cached badge is reused while the index mtime is
+// unchanged. Returns false if cancelled.
+static bool git_probe(const char *dir, const EntryGit *cached, EntryGit *out,
+                      atomic_bool *cancel) {
+  *out = (EntryGit){.state = GIT_NONE};
+
+  Z_CLEANUP(zstr_free) zstr git_dir = zstr_init();
+  if (!find_git_dir(dir, &git_dir))
+    return true;
+
+  // HEAD is one small read, so the branch is always current
+  read_head(zstr_cstr(&git_dir), out->branch, sizeof(out->branch));
+
+  Z_CLEANUP(zstr_free) zstr index_path = join_path(zstr_cstr(&git_dir), "index");
+  int fd = open(zstr_cstr(&index_path), O_RDONLY | O_CLOEXEC);
+  struct stat sb;
+  if (fd < 0 || fstat(fd, &sb) != 0) {
+    // No index yet: nothing is tracked
+    out->state = fd < 0 && errno == ENOENT ? GIT_CLEAN : GIT_REPO;
+    if (fd >= 0)
+      close(fd);
+    return true;
+  }
+  out->index_sec = (int64_t)sb.st_mtime;
+  out->index_nsec = (int64_t)STAT_MTIME_NSEC(sb);
+
+  if (cached->state >= GIT_REPO && cached->index_sec == out->index_sec &&
+      cached->index_nsec == out->index_nsec) {
+    close(fd);
+    out->state = cached->state;
+    return true;
+  }
+
+  out->state = GIT_REPO;
+  void *map = sb.st_size > 0
+                  ? mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+                  : MAP_FAILED;
+  close(fd);
+  int wtfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (map != MAP_FAILED && wtfd >= 0) {
+    out->state = compare_index(map, (size_t)sb.st_size, wtfd, cancel);
+  }
+  if (wtfd >= 0)
+    close(wtfd);
+  if (map != MAP_FAILED)
+    munmap(map, (size_t)sb.st_size);
+  return out->state != GIT_UNKNOWN;
+}
+
+// ============================================================================
+// Worker
+// ============================================================================
+
+static void *worker_main(void *arg) {
+  GitStatus *gs = arg;
+
+  pthread_mutex_lock(&gs->lock);
+  while (!gs->stop) {
+    if (gs->queue.length == 0) {
+      pthread_cond_wait(&gs->wake, &gs->lock);
+      continue;
+    }
+
+    GitJob job = gs->queue.data[0];
+    memmove(gs->queue.data, gs->queue.data + 1,
+            (gs->queue.length - 1) * sizeof(GitJob));
+    gs->queue.length--;
+    gs->current = job.entry;
+    atomic_store(&gs->cancel, false);
+    pthread_mutex_unlock(&gs->lock);
+
+    EntryGit fresh;
+    bool finished = git_probe(zstr_cstr(&job.path), &job.git, &fresh, &gs->cancel);
+
+    pthread_mutex_lock(&gs->lock);
+    gs->current = NO_ENTRY;
+    if (finished && !atomic_load(&gs->cancel)) {
+      job.git = fresh;
+      vec_push_GitJob(&gs->results, job);
+    } else {
+      zstr_free(&job.path);
+    }
+  }
+  pthread_mutex_unlock(&gs->lock);
+  return NULL;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+GitStatus *git_status_new(void) {
+  GitStatus *gs = calloc(1, sizeof(GitStatus));
+  if (!gs)
+    return NULL;
+  pthread_mutex_init(&gs->lock, NULL);
+  pthread_cond_init(&gs->wake, NULL);
+  gs->current = NO_ENTRY;
+  atomic_init(&gs->cancel, false);
+  return gs;
+}
+
+static bool contains_u32(const uint32_t *list, size_t count, uint32_t value) {
+  for (size_t i = 0; i < count; i++) {
+    if (list[i] == value)
+      return true;
+  }
+  return false;
+}
+
+void git_status_want(GitStatus *gs, const EntryStore *store,
+                     const uint32_t *entries, size_t count) {
+  if (!gs)
+    return;
+  // Most frames show the same rows as the last one
+  if (count == gs->visible.length &&
+      (count == 0 || memcmp(entries, gs->visible.data, count * sizeof(uint32_t)) == 0))
+    return;
+
+  pthread_mutex_lock(&gs->lock);
+
+  // Rebuild the queue in screen order: keep pending probes of rows still
+  // visible, add rows that just came into view, drop the rest
+  vec_GitJob queue = {0};
+  for (size_t i = 0; i < count; i++) {
+    uint32_t entry = entries[i];
+    bool queued = false;
+    for (size_t q = 0; q < gs->queue.length; q++) {
+      if (gs->queue.data[q].entry == entry) {
+        vec_push_GitJob(&queue, gs->queue.data[q]);
+        gs->queue.data[q].entry = NO_ENTRY;
+        queued = true;
+        break;
+      }
+    }
+    if (queued || contains_u32(gs->visible.data, gs->visible.length, entry))
+      continue;
+    if (entry == gs->current && !atomic_load(&gs->cancel))
+      continue;
+    vec_push_GitJob(&queue, (GitJob){.entry = entry,
+                                     .path = entry_path(store, entry),
+                                     .git = store->git.data[entry]});
+  }
+  for (size_t q = 0; q < gs->queue.length; q++) {
+    if (gs->queue.data[q].entry != NO_ENTRY)
+      zstr_free(&gs->queue.data[q].path);
+  }
+  vec_free_GitJob(&gs->queue);
+  gs->queue = queue;
+
+  if (gs->current != NO_ENTRY && !contains_u32(entries, count, gs->current))
+    atomic_store(&gs->cancel, true);
+
+  if (!gs->started && gs->queue.length > 0) {
+    gs->started = pthread_create(&gs->thread, NULL, worker_main, gs) == 0;
+  }
+  pthread_cond_signal(&gs->wake);
+  pthread_mutex_unlock(&gs->lock);
+
+  vec_clear_u32(&gs->visible);
+  for (size_t i = 0; i < count; i++)
+    vec_push_u32(&gs->visible, entries[i]);
+}
+
+bool git_status_poll(GitStatus *gs, EntryStore *store) {
+  if (!gs)
+    return false;
+
+  bool changed = false;
+  GitJob *job;
+  pthread_mutex_lock(&gs->lock);
+  vec_foreach(&gs->results, job) {
+    EntryGit *git = entry_git(store, job->entry);
+    if (git->state != job->git.state || strcmp(git->branch, job->git.branch) != 0)
+      changed = true;
+    *git = job->git;
+    zstr_free(&job->path);
+  }
+  vec_clear_GitJob(&gs->results);
+  pthread_mutex_unlock(&gs->lock);
+  return changed;
+}
+
+bool git_status_busy(GitStatus *gs) {
+  if (!gs)
+    return false;
+  pthread_mutex_lock(&gs->lock);
+  bool busy = gs->queue.length > 0 || gs->current != NO_ENTRY ||
+              gs->results.length > 0;
+  pthread_mutex_unlock(&gs->lock);
+  return busy;
+}
+
+void git_status_free(GitStatus *gs) {
+  if (!gs)
+    return;
+
+  pthread_mutex_lock(&gs->lock);
+  gs->stop = true;
+  atomic_store(&gs->cancel, true);
+  pthread_cond_signal(&gs->wake);
+  pthread_mutex_unlock(&gs->lock);
+  if (gs->started)
+    pthread_join(gs->thread, NULL);
+
+  GitJob *job;
+  vec_foreach(&gs->queue, job) zstr_free(&job->path);
+  vec_foreach(&gs->results, job) zstr_free(&job->path);
+  vec_free_GitJob(&gs->queue);
+  vec_free_GitJob(&gs->results);
+  vec_free_u32(&gs->visible);
+  pthread_cond_destroy(&gs->wake);
+  pthread_mutex_destroy(&gs->lock);
+  free(gs);
+}
@@ -0,0 +1,42 @@
+#ifndef GITSTATUS_H
+#define GITSTATUS_H
+
+#include "entries.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Git status badges
+// ============================================================================
+//
+// A background thread reads the git metadata of the rows on screen without
+// running `git`: the branch comes from HEAD, and the work tree is dirty when
+// the index has unmerged entries or a tracked file's stat data (size, mtime)
+// no longer matches its index entry. Untracked files and changes that are
+// only staged are not detected.
+//
+// Results are cached in the entry's EntryGit by the index mtime, so a row
+// that scrolls back into view only costs a stat() unless the index changed.
+// Rows scrolled away are dropped from the queue and a probe in progress for
+// one of them is cancelled.
+
+typedef struct GitStatus GitStatus;
+
+GitStatus *git_status_new(void);
+
+// Sets the rows on screen, in priority order. Rows that just became visible
+// are queued for a probe; the worker thread is started on first use.
+void git_status_want(GitStatus *gs, const EntryStore *store,
+                     const uint32_t *entries, size_t count);
+
+// Copies finished probes into the store. Returns true if any badge changed.
+bool git_status_poll(GitStatus *gs, EntryStore *store);
+
+// True while probes are queued or running
+bool git_status_busy(GitStatus *gs);
+
+// Stops the worker and frees gs (NULL is ignored)
+void git_status_free(GitStatus *gs);
+
+#endif // GITSTATUS_H
@@ -0,0 +1,272 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "history.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HISTORY_MAGIC "TRYHIST1"
+#define HISTORY_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+} HistoryHeader;
+
+typedef struct {
+  uint64_t hash;
+  int64_t time;
+} HistoryRecord;
+
+uint64_t history_hash(const char *name) {
+  // FNV-1a, never 0 (0 marks empty hash table slots)
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+    h ^= *p;
+    h *= 0x100000001b3ULL;
+  }
+  return h ? h : 1;
+}
+
+// Visit weight by age (buckets as in Firefox/zoxide frecency)
+static float visit_weight(double age_seconds) {
+  if (age_seconds < 3600)
+    return 4.0f;
+  if (age_seconds < 86400)
+    return 2.0f;
+  if (age_seconds < 7 * 86400)
+    return 0.5f;
+  return 0.25f;
+}
+
+static HistoryStat *history_slot(History *h, uint64_t hash) {
+  size_t mask = h->capacity - 1;
+  size_t i = (size_t)hash & mask;
+  while (h->slots[i].hash != 0 && h->slots[i].hash != hash)
+    i = (i + 1) & mask;
+  return &h->slots[i];
+}
+
+// Maps the record array of a history file. Returns NULL if missing/invalid.
+static const HistoryRecord *history_map(const char *path, size_t *count,
+                                        void **map, size_t *map_len) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+
+  struct stat sb;
+  if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(HistoryHeader)) {
+    close(fd);
+    return NULL;
+  }
+
+  void *p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+    return NULL;
+
+  const HistoryHeader *hdr = p;
+  if (memcmp(hdr->magic, HISTORY_MAGIC, 8) != 0 ||
+      hdr->version != HISTORY_VERSION) {
+    munmap(p, (size_t)sb.st_size);
+    return NULL;
+  }
+
+  *map = p;
+  *map_len = (size_t)sb.st_size;
+  // A torn trailing record (crash mid-append) is simply ignored
+  *count = ((size_t)sb.st_size - sizeof(HistoryHeader)) / sizeof(HistoryRecord);
+  return (const HistoryRecord *)((const char *)p + sizeof(HistoryHeader));
+}
+
+void history_load(History *h, const char *tries_path, time_t now) {
+  *h = (History){0};
+
+  Z_CLEANUP(zstr_free) zstr path = join_path(tries_path, HISTORY_FILE);
+  void *map = NULL;
+  size_t map_len = 0, count = 0;
+  const HistoryRecord *recs =
+      history_map(zstr_cstr(&path), &count, &map, &map_len);
+  if (!recs)
+    return;
+
+  // Load factor <= 0.5 even if every record is a distinct directory
+  size_t cap = 16;
+  while (cap < count * 2)
+    cap *= 2;
+  h->slots = calloc(cap, sizeof(HistoryStat));
+  if (!h->slots) {
+    munmap(map, map_len);
+    return;
+  }
+  h->capacity = cap;
+
+  for (size_t i = 0; i < count; i++) {
+    HistoryStat *st = history_slot(h, recs[i].hash);
+    if (st->hash == 0) {
+      st->hash = recs[i].hash;
+      h->count++;
+    }
+    time_t t = (time_t)recs[i].time;
+    if (t > st->last_access)
+      st->last_access = t;
+    st->visits++;
+    st->frecency += visit_weight(difftime(now, t));
+  }
+
+  munmap(map, map_len);
+}
+
+void history_free(History *h) {
+  free(h->slots);
+  *h = (History){0};
+}
+
+const HistoryStat *history_lookup(const History *h, const char *name) {
+  if (h->capacity == 0)
+    return NULL;
+  HistoryStat *st = history_slot((History *)h, history_hash(name));
+  return st->hash ? st : NULL;
+}
+
+// Newest first within each directory
+static int compare_records(const void *a, const void *b) {
+  const HistoryRecord *ra = a, *rb = b;
+  if (ra->hash != rb->hash)
+    return ra->hash < rb->hash ? -1 : 1;
+  if (ra->time != rb->time)
+    return ra->time > rb->time ? -1 : 1;
+  return 0;
+}
+
+static int compare_records_by_time(const void *a, const void *b) {
+  const HistoryRecord *ra = a, *rb = b;
+  if (ra->time != rb->time)
+    return ra->time > rb->time ? -1 : 1;
+  return 0;
+}
+
+// Rewrites the log keeping the newest visits per directory, and at most half
+// the compaction threshold overall so compactions stay amortized
+static void history_compact(const char *path, time_t now) {
+  void *map = NULL;
+  size_t map_len = 0, count = 0;
+  const HistoryRecord *recs = history_map(path, &count, &map, &map_len);
+  if (!recs)
+    return;
+
+  HistoryRecord *sorted = malloc(count * sizeof(HistoryRecord));
+  if (!sorted) {
+    munmap(map, map_len);
+    return;
+  }
+  memcpy(sorted, recs, count * sizeof(HistoryRecord));
+  munmap(map, map_len);
+  qsort(sorted, count, sizeof(HistoryRecord), compare_records);
+
+  size_t kept = 0, run = 0;
+  int64_t cutoff = (int64_t)now - (int64_t)HISTORY_MAX_AGE_DAYS * 86400;
+  for (size_t i = 0; i < count; i++) {
+    run = (i > 0 && sorted[i].hash == sorted[i - 1].hash) ? run + 1 : 0;
+    if (run < HISTORY_KEEP_VISITS && sorted[i].time >= cutoff)
+      sorted[kept++] = sorted[i];
+  }
+  if (kept > HISTORY_COMPACT_RECORDS / 2) {
+    qsort(sorted, kept, sizeof(HistoryRecord), compare_records_by_time);
+    kept = HISTORY_COMPACT_RECORDS / 2;
+  }
+
+  HistoryHeader hdr = {.version = HISTORY_VERSION};
+  memcpy(hdr.magic, HISTORY_MAGIC, 8);
+  write_file_atomic(path, &hdr, sizeof(hdr), sorted, kept * sizeof(HistoryRecord));
+  free(sorted);
+}
+
+// Opens the log for appending under an exclusive flock(), which serializes
+// header creation, appends and compaction between processes. A compaction
+// renames a new log over the path, so if that happened while we waited for
+// the lock, the open file is stale and the new one is opened instead.
+static int history_open_locked(const char *path) {
+  for (;;) {
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+      return -1;
+    struct stat held, cur;
+    if (flock(fd, LOCK_EX) != 0 || fstat(fd, &held) != 0) {
+      close(fd);
+      return -1;
+    }
+    if (stat(path, &cur) == 0 && cur.st_dev == held.st_dev &&
+        cur.st_ino == held.st_ino)
+      return fd;
+    close(fd);
+  }
+}
+
+int history_record(const char *tries_path, const char *name, time_t when) {
+  Z_CLEANUP(zstr_free) zstr path = join_path(tries_path, HISTORY_FILE);
+  const char *p = zstr_cstr(&path);
+
+  int fd = history_open_locked(p);
+  if (fd < 0)
+    return -1;
+
+  struct stat sb;
+  if (fstat(fd, &sb) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  // New (or truncated) file: write the header first
+  if ((size_t)sb.st_size < sizeof(HistoryHeader)) {
+    if (ftruncate(fd, 0) != 0) {
+      close(fd);
+      return -1;
+    }
+    HistoryHeader hdr = {.version = HISTORY_VERSION};
+    memcpy(hdr.magic, HISTORY_MAGIC, 8);
+    if (write(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) {
+      close(fd);
+      return -1;
+    }
+    sb.st_size = sizeof(hdr);
+  } else {
+    // Drop a torn trailing record so later appends stay aligned
+    off_t tail = (sb.st_size - (off_t)sizeof(HistoryHeader)) %
+                 (off_t)sizeof(HistoryRecord);
+    if (tail != 0) {
+      sb.st_size -= tail;
+      if (ftruncate(fd, sb.st_size) != 0) {
+        close(fd);
+        return -1;
+      }
+    }
+  }
+
+  HistoryRecord rec = {.hash = history_hash(name), .time = (int64_t)when};
+  if (write(fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec)) {
+    close(fd);
+    return -1;
+  }
+
+  // Still holding the lock, so no append can land in the log being replaced
+  size_t records = ((size_t)sb.st_size - sizeof(HistoryHeader)) /
+                   sizeof(HistoryRecord) + 1;
+  if (records > HISTORY_COMPACT_RECORDS)
+    history_compact(p, when);
+
+  close(fd);
+  return 0;
+}
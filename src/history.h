@@ -0,0 +1,55 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// ============================================================================
+// Access History (frecency)
+// ============================================================================
+//
+// Every selection appends one fixed-size record to <tries>/.try_history:
+//
+//   header:  "TRYHIST1" magic, uint32 version, uint32 reserved  (16 bytes)
+//   record:  uint64 FNV-1a hash of the directory name,
+//            int64 access time (unix seconds)                   (16 bytes)
+//
+// The file is mmap'd and folded into a small hash table at scan time, so
+// loading costs one pass over a few KB. Appends use O_APPEND writes of a
+// single record; once the file grows past HISTORY_COMPACT_RECORDS it is
+// rewritten keeping only the most recent visits per directory.
+
+#define HISTORY_FILE ".try_history"
+#define HISTORY_COMPACT_RECORDS 4096  // Compact once the log exceeds this
+#define HISTORY_KEEP_VISITS 10        // Visits kept per directory on compaction
+#define HISTORY_MAX_AGE_DAYS 90       // Visits older than this are dropped
+
+typedef struct {
+  uint64_t hash;        // 0 = empty slot
+  time_t last_access;
+  uint32_t visits;
+  float frecency;       // Sum of age-weighted visits
+} HistoryStat;
+
+typedef struct {
+  HistoryStat *slots;
+  size_t capacity;      // Power of two
+  size_t count;
+} History;
+
+uint64_t history_hash(const char *name);
+
+// Loads and aggregates the history of a tries directory (empty if missing)
+void history_load(History *h, const char *tries_path, time_t now);
+void history_free(History *h);
+
+// Returns NULL if the name was never selected
+const HistoryStat *history_lookup(const History *h, const char *name);
+
+// Appends an access record, compacting the log when it gets large
+// Returns 0 on success, -1 on error
+int history_record(const char *tries_path, const char *name, time_t when);
+
+#endif // HISTORY_H
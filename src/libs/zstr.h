@@ -84,6 +84,22 @@
 #include <ctype.h>
 #include <stdlib.h> 
 
+// Vector Paths.
+// Case conversion and the UTF-8 scans work on 16-byte blocks when the target
+// has SSE2 or NEON, with scalar tails. Define Z_NO_SIMD to keep everything
+// scalar.
+#if !defined(Z_NO_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    #if defined(__SSE2__)
+        #include <emmintrin.h>
+        #define ZSTR_SIMD_SSE2 1
+        #define ZSTR_SIMD_BLOCK 16
+    #elif defined(__ARM_NEON)
+        #include <arm_neon.h>
+        #define ZSTR_SIMD_NEON 1
+        #define ZSTR_SIMD_BLOCK 16
+    #endif
+#endif
+
 // I am thinking of you too, C++ devs.
 #ifdef __cplusplus
 extern "C" {
@@ -202,6 +218,93 @@ static inline bool zstr_is_empty(const zstr *s)
 }
 
 
+/* Vector Helpers (Internal) */
+
+#if defined(ZSTR_SIMD_BLOCK)
+
+// Each target provides loads, compares and a bit mask of the true lanes
+// (ZSTR_MASK_STRIDE bits per byte).
+#if defined(ZSTR_SIMD_SSE2)
+typedef __m128i zstr__vec;
+#define ZSTR_MASK_STRIDE 1
+
+static inline zstr__vec zstr__load(const char *p) { return _mm_loadu_si128((const __m128i *)p); }
+static inline void zstr__store(char *p, zstr__vec v) { _mm_storeu_si128((__m128i *)p, v); }
+static inline zstr__vec zstr__splat(char c) { return _mm_set1_epi8(c); }
+static inline zstr__vec zstr__eq(zstr__vec a, zstr__vec b) { return _mm_cmpeq_epi8(a, b); }
+static inline uint64_t zstr__mask(zstr__vec v) { return (uint32_t)_mm_movemask_epi8(v); }
+
+// Lanes with the high bit set (non-ASCII).
+static inline uint64_t zstr__high(zstr__vec v) { return zstr__mask(v); }
+
+// Flips the case of the letters in [first, first + 25].
+static inline zstr__vec zstr__flip_case(zstr__vec v, char first)
+{
+    zstr__vec shifted = _mm_add_epi8(v, _mm_set1_epi8((char)(128 - first)));
+    zstr__vec letter = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+    return _mm_xor_si128(v, _mm_and_si128(letter, _mm_set1_epi8(0x20)));
+}
+#elif defined(ZSTR_SIMD_NEON)
+typedef uint8x16_t zstr__vec;
+#define ZSTR_MASK_STRIDE 4
+
+static inline zstr__vec zstr__load(const char *p) { return vld1q_u8((const uint8_t *)p); }
+static inline void zstr__store(char *p, zstr__vec v) { vst1q_u8((uint8_t *)p, v); }
+static inline zstr__vec zstr__splat(char c) { return vdupq_n_u8((uint8_t)c); }
+static inline zstr__vec zstr__eq(zstr__vec a, zstr__vec b) { return vceqq_u8(a, b); }
+
+// No movemask: narrow each lane to a nibble and keep one bit of it.
+static inline uint64_t zstr__mask(zstr__vec v)
+{
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ULL;
+}
+
+static inline uint64_t zstr__high(zstr__vec v) { return zstr__mask(vcgeq_u8(v, vdupq_n_u8(0x80))); }
+
+static inline zstr__vec zstr__flip_case(zstr__vec v, char first)
+{
+    uint8x16_t letter = vcltq_u8(vsubq_u8(v, vdupq_n_u8((uint8_t)first)), vdupq_n_u8(26));
+    return veorq_u8(v, vandq_u8(letter, vdupq_n_u8(0x20)));
+}
+#endif
+
+// Index of the first true lane of a non-zero mask.
+static inline size_t zstr__first_lane(uint64_t mask)
+{
+    return (size_t)__builtin_ctzll(mask) / ZSTR_MASK_STRIDE;
+}
+
+// Flips the case of the letters in [first, first + 25] over the whole blocks
+// of p and returns how many bytes that covered.
+static inline size_t zstr__flip_case_blocks(char *p, size_t len, char first)
+{
+    size_t i = 0;
+    for (; i + ZSTR_SIMD_BLOCK <= len; i += ZSTR_SIMD_BLOCK)
+    {
+        zstr__store(p + i, zstr__flip_case(zstr__load(p + i), first));
+    }
+    return i;
+}
+
+// Length of the leading run of ASCII, non-NUL bytes (whole blocks only, so
+// it can stop short of the real end of the run).
+static inline size_t zstr__ascii_span(const char *p, size_t len)
+{
+    zstr__vec zero = zstr__splat(0);
+    size_t i = 0;
+    for (; i + ZSTR_SIMD_BLOCK <= len; i += ZSTR_SIMD_BLOCK)
+    {
+        zstr__vec v = zstr__load(p + i);
+        uint64_t stop = zstr__high(v) | zstr__mask(zstr__eq(v, zero));
+        if (stop) return i + zstr__first_lane(stop);
+    }
+    return i;
+}
+
+#endif // ZSTR_SIMD_BLOCK
+
+
 /* Creation and Destruction */
 
 // Initializes an empty string {0}.
@@ -574,7 +677,11 @@ static inline void zstr_to_lower(zstr *s)
 {
     char *p = zstr_data(s);
     size_t len = zstr_len(s);
-    for (size_t i = 0; i < len; i++)
+    size_t i = 0;
+#if defined(ZSTR_SIMD_BLOCK)
+    i = zstr__flip_case_blocks(p, len, 'A');
+#endif
+    for (; i < len; i++)
     {
         p[i] = (char)tolower((unsigned char)p[i]);
     }
@@ -585,7 +692,11 @@ static inline void zstr_to_upper(zstr *s)
 {
     char *p = zstr_data(s);
     size_t len = zstr_len(s);
-    for (size_t i = 0; i < len; i++)
+    size_t i = 0;
+#if defined(ZSTR_SIMD_BLOCK)
+    i = zstr__flip_case_blocks(p, len, 'a');
+#endif
+    for (; i < len; i++)
     {
         p[i] = (char)toupper((unsigned char)p[i]);
     }
@@ -795,9 +906,22 @@ static inline uint32_t zstr_next_rune(const char **p)
 static inline size_t zstr_count_runes(const zstr *s)
 {
     const char *ptr = zstr_cstr(s);
+#if defined(ZSTR_SIMD_BLOCK)
+    const char *end = ptr + zstr_len(s);
+#endif
     size_t count = 0;
     while (*ptr)
     {
+#if defined(ZSTR_SIMD_BLOCK)
+        // ASCII runs are one rune per byte.
+        if ((unsigned char)*ptr < 0x80 && end - ptr >= ZSTR_SIMD_BLOCK)
+        {
+            size_t run = zstr__ascii_span(ptr, (size_t)(end - ptr));
+            ptr += run;
+            count += run;
+            if (run) continue;
+        }
+#endif
         zstr_next_rune(&ptr);
         count++;   
     }
@@ -809,11 +933,26 @@ static inline size_t zstr_count_runes(const zstr *s)
 static inline bool zstr_is_valid_utf8(const zstr *s)
 {
     const unsigned char *p = (const unsigned char *)zstr_cstr(s);
+#if defined(ZSTR_SIMD_BLOCK)
+    const unsigned char *end = p + zstr_len(s);
+#endif
     while (*p)
     {
         if (*p < 0x80) 
         {
+#if defined(ZSTR_SIMD_BLOCK)
+            if (end - p >= ZSTR_SIMD_BLOCK)
+            {
+                size_t run = zstr__ascii_span((const char *)p, (size_t)(end - p));
+                p += run ? run : 1;
+            }
+            else
+            {
+                p++;
+            }
+#else
             p++; 
+#endif
         } 
         else if ((*p & 0xE0) == 0xC0) // 2-byte.
         {
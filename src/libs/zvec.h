@@ -259,6 +259,132 @@ static inline T* vec_lower_bound_##Name(vec_##Name *v, const T *key,
     return &v->data[l];                                                                     \
 }
 
+// Type-specialized sorting.
+// Generates sorts over plain arrays of T where the order is the expression
+// Less(a, b) (a macro or function taking two T values, a strict weak order),
+// so the compiler inlines the comparison instead of calling through a
+// qsort() pointer:
+//
+//   zsort_Name(a, n)             introsort (quicksort, heapsort fallback)
+//   zsort_nth_Name(a, n, k)      a[k] ends up where a sort would put it, with
+//                                nothing after it ordered before it and
+//                                nothing before it ordered after it
+//   zsort_partial_Name(a, n, k)  sorts the first k elements of the order
+//
+// Like qsort(), none of them are stable.
+#define Z_SORT_GENERATE_IMPL(T, Name, Less)                                                 \
+                                                                                            \
+static inline void zsort_insertion_##Name(T *a, size_t n) {                                 \
+    for (size_t i = 1; i < n; i++) {                                                        \
+        T x = a[i];                                                                         \
+        size_t j = i;                                                                       \
+        while (j > 0 && Less(x, a[j - 1])) {                                                \
+            a[j] = a[j - 1];                                                                \
+            j--;                                                                            \
+        }                                                                                   \
+        a[j] = x;                                                                           \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline void zsort_sift_##Name(T *a, size_t root, size_t n) {                         \
+    T x = a[root];                                                                          \
+    for (;;) {                                                                              \
+        size_t child = 2 * root + 1;                                                        \
+        if (child >= n) break;                                                              \
+        if (child + 1 < n && Less(a[child], a[child + 1])) child++;                         \
+        if (!Less(x, a[child])) break;                                                      \
+        a[root] = a[child];                                                                 \
+        root = child;                                                                       \
+    }                                                                                       \
+    a[root] = x;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline void zsort_heap_##Name(T *a, size_t n) {                                      \
+    for (size_t i = n / 2; i-- > 0;) zsort_sift_##Name(a, i, n);                            \
+    for (size_t end = n; end-- > 1;) {                                                      \
+        T top = a[0];                                                                       \
+        a[0] = a[end];                                                                      \
+        a[end] = top;                                                                       \
+        zsort_sift_##Name(a, 0, end);                                                       \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline size_t zsort_partition_##Name(T *a, size_t n) {                               \
+    size_t mid = n / 2;                                                                     \
+    T t;                                                                                    \
+    if (Less(a[mid], a[0])) { t = a[mid]; a[mid] = a[0]; a[0] = t; }                        \
+    if (Less(a[n - 1], a[mid])) {                                                           \
+        t = a[mid]; a[mid] = a[n - 1]; a[n - 1] = t;                                        \
+        if (Less(a[mid], a[0])) { t = a[mid]; a[mid] = a[0]; a[0] = t; }                    \
+    }                                                                                       \
+    T pivot = a[mid];                                                                       \
+    size_t i = 0, j = n - 1;                                                                \
+    for (;;) {                                                                              \
+        do i++; while (Less(a[i], pivot));                                                  \
+        do j--; while (Less(pivot, a[j]));                                                  \
+        if (i >= j) return j + 1;                                                           \
+        t = a[i]; a[i] = a[j]; a[j] = t;                                                    \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline int zsort_depth_##Name(size_t n) {                                            \
+    int depth = 0;                                                                          \
+    while (n > 1) { n >>= 1; depth += 2; }                                                  \
+    return depth;                                                                           \
+}                                                                                           \
+                                                                                            \
+static inline void zsort_intro_##Name(T *a, size_t n, int depth) {                         \
+    while (n > 16) {                                                                        \
+        if (depth-- == 0) {                                                                 \
+            zsort_heap_##Name(a, n);                                                        \
+            return;                                                                         \
+        }                                                                                   \
+        size_t p = zsort_partition_##Name(a, n);                                            \
+        if (p < n - p) {                                                                    \
+            zsort_intro_##Name(a, p, depth);                                                \
+            a += p;                                                                         \
+            n -= p;                                                                         \
+        } else {                                                                            \
+            zsort_intro_##Name(a + p, n - p, depth);                                        \
+            n = p;                                                                          \
+        }                                                                                   \
+    }                                                                                       \
+    zsort_insertion_##Name(a, n);                                                           \
+}                                                                                           \
+                                                                                            \
+static inline void zsort_##Name(T *a, size_t n) {                                           \
+    zsort_intro_##Name(a, n, zsort_depth_##Name(n));                                        \
+}                                                                                           \
+                                                                                            \
+static inline void zsort_nth_##Name(T *a, size_t n, size_t k) {                             \
+    if (k >= n) return;                                                                     \
+    int depth = zsort_depth_##Name(n);                                                      \
+    while (n > 16) {                                                                        \
+        if (depth-- == 0) {                                                                 \
+            zsort_heap_##Name(a, n);                                                        \
+            return;                                                                         \
+        }                                                                                   \
+        size_t p = zsort_partition_##Name(a, n);                                            \
+        if (k < p) {                                                                        \
+            n = p;                                                                          \
+        } else {                                                                            \
+            a += p;                                                                         \
+            n -= p;                                                                         \
+            k -= p;                                                                         \
+        }                                                                                   \
+    }                                                                                       \
+    zsort_insertion_##Name(a, n);                                                           \
+}                                                                                           \
+                                                                                            \
+static inline void zsort_partial_##Name(T *a, size_t n, size_t k) {                         \
+    if (k >= n) {                                                                           \
+        zsort_##Name(a, n);                                                                 \
+        return;                                                                             \
+    }                                                                                       \
+    zsort_nth_##Name(a, n, k);                                                              \
+    zsort_##Name(a, k);                                                                     \
+}
+
 #define PUSH_ENTRY(T, Name)     vec_##Name*: vec_push_##Name,
 #define PUSH_SLOT_ENTRY(T, Name) vec_##Name*: vec_push_slot_##Name,
 #define EXTEND_ENTRY(T, Name)   vec_##Name*: vec_extend_##Name,
@@ -7,15 +7,14 @@
 
 #include "commands.h"
 #include "config.h"
+#include "simd.h"
+#include "trash.h"
 #include "utils.h"
 #include "tui.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Global flag for disabling colors (shared with other modules)
-bool tui_no_colors = false;
-
 // Compact help for direct mode
 static void print_help(void) {
   Z_CLEANUP(zstr_free) zstr default_path = get_default_tries_path();
@@ -62,6 +61,18 @@ static void print_help(void) {
   tui_zstr_printf(&help, TUI_DIM, "Create worktree from current git repo");
   zstr_cat(&help, "\n");
 
+  zstr_cat(&help, "  ");
+  tui_zstr_printf(&help, TUI_BOLD, "try list");
+  zstr_cat(&help, " [--by-size] ");
+  tui_zstr_printf(&help, TUI_DIM, "List directories (largest first with --by-size)");
+  zstr_cat(&help, "\n");
+
+  zstr_cat(&help, "  ");
+  tui_zstr_printf(&help, TUI_BOLD, "try archive");
+  zstr_cat(&help, "          ");
+  tui_zstr_printf(&help, TUI_DIM, "Compress directories untouched for 90 days (--days N)");
+  zstr_cat(&help, "\n");
+
   zstr_cat(&help, "  ");
   tui_zstr_printf(&help, TUI_BOLD, "try exec");
   zstr_cat(&help, " [query]     ");
@@ -82,7 +93,9 @@ static void print_help(void) {
   tui_zstr_printf(&help, TUI_BOLD, "~/src/tries");
   zstr_cat(&help, " (override with ");
   tui_zstr_printf(&help, TUI_BOLD, "--path");
-  zstr_cat(&help, " on init)\n");
+  zstr_cat(&help, " on init; ");
+  tui_zstr_printf(&help, TUI_BOLD, "a:b");
+  zstr_cat(&help, " searches several roots)\n");
 
   zstr_cat(&help, "  Current: ");
   tui_zstr_printf(&help, TUI_BOLD, zstr_cstr(&default_path));
@@ -132,10 +145,27 @@ static const char *parse_option_value(const char *arg, const char *next_arg,
   return NULL;
 }
 
+static void free_roots(vec_zstr *roots) {
+  zstr *root;
+  vec_foreach(roots, root) {
+    zstr_free(root);
+  }
+  vec_free_zstr(roots);
+}
+
 int main(int argc, char **argv) {
-  Z_CLEANUP(zstr_free) zstr tries_path = zstr_init();
+  Z_CLEANUP(zstr_free) zstr tries_path = zstr_init();  // Colon-separated roots
+  Z_CLEANUP(free_roots) vec_zstr roots = {0};
   Z_CLEANUP(vec_free_char_ptr) vec_char_ptr cmd_args = vec_init_capacity_char_ptr(argc);
 
+  // Vector kernels for this CPU, before any worker threads start
+  simd_init();
+
+  // Background trash purger started by trash_purge_async()
+  if (argc == 3 && strcmp(argv[1], TRASH_PURGE_FLAG) == 0) {
+    return trash_purge_main(argv[2]);
+  }
+
   // Check NO_COLOR environment variable (https://no-color.org/)
   if (getenv("NO_COLOR") != NULL) {
     tui_no_colors = true;
@@ -172,8 +202,10 @@ int main(int argc, char **argv) {
 
     // Options with values
     if ((value = parse_option_value(arg, next, "--path", &skip))) {
-      zstr_free(&tries_path);
-      tries_path = zstr_from(value);
+      // Repeated --path adds roots
+      if (!zstr_is_empty(&tries_path))
+        zstr_push(&tries_path, ':');
+      zstr_cat(&tries_path, value);
       i += skip;
       continue;
     }
@@ -192,12 +224,19 @@ int main(int argc, char **argv) {
     tries_path = get_default_tries_path();
   }
 
-  if (zstr_is_empty(&tries_path)) {
+  // The first root is primary: new tries, clones and worktrees go there;
+  // the selector searches all of them
+  split_tries_path(zstr_cstr(&tries_path), &roots);
+  if (roots.length == 0) {
     fprintf(stderr, "Error: Could not determine tries path. Set HOME or use --path.\n");
     return 1;
   }
 
-  const char *path_cstr = zstr_cstr(&tries_path);
+  // Normalized list for the shell function written by init
+  zstr_free(&tries_path);
+  tries_path = join_tries_path(&roots);
+
+  const char *path_cstr = zstr_cstr(&roots.data[0]);
 
   // Ensure tries directory exists
   if (!dir_exists(path_cstr)) {
@@ -217,13 +256,17 @@ int main(int argc, char **argv) {
 
   // Route commands
   if (strcmp(command, "init") == 0) {
-    cmd_init((int)cmd_args.length - 1, cmd_args.data + 1, path_cstr);
+    cmd_init((int)cmd_args.length - 1, cmd_args.data + 1, zstr_cstr(&tries_path));
     return 0;
+  } else if (strcmp(command, "archive") == 0) {
+    return cmd_archive((int)cmd_args.length - 1, cmd_args.data + 1, path_cstr);
+  } else if (strcmp(command, "list") == 0) {
+    return cmd_list((int)cmd_args.length - 1, cmd_args.data + 1, path_cstr);
   } else if (strcmp(command, "exec") == 0) {
     // Exec mode - route subcommand and print script
     exec_mode = true;
     Z_CLEANUP(zstr_free) zstr script = cmd_route(
-        (int)cmd_args.length - 1, cmd_args.data + 1, path_cstr, &test);
+        (int)cmd_args.length - 1, cmd_args.data + 1, &roots, &test);
     if (zstr_is_empty(&script)) {
       return 1; // Error or special case (like init)
     }
@@ -231,7 +274,7 @@ int main(int argc, char **argv) {
   } else if (strcmp(command, "cd") == 0) {
     // Direct mode cd (interactive selector)
     Z_CLEANUP(zstr_free) zstr script = cmd_selector(
-        (int)cmd_args.length - 1, cmd_args.data + 1, path_cstr, &test);
+        (int)cmd_args.length - 1, cmd_args.data + 1, &roots, &test);
     if (zstr_is_empty(&script)) {
       return 1;
     }
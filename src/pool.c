@@ -0,0 +1,266 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "pool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define POOL_MAX_THREADS 16
+
+typedef struct {
+  PoolTaskFn fn;
+  void *arg;
+} PoolTask;
+
+// Growable ring buffer; the owner uses the back, thieves the front
+typedef struct {
+  pthread_mutex_t lock;
+  PoolTask *tasks;
+  size_t cap;
+  size_t head;
+  size_t count;
+} PoolDeque;
+
+typedef struct {
+  Pool *pool;
+  int index;
+} PoolWorker;
+
+struct Pool {
+  int nthreads;          // Workers actually started
+  int ndeques;           // Fixed before any worker starts
+  pthread_t *threads;
+  PoolWorker *workers;
+  PoolDeque *deques;
+
+  atomic_size_t queued;  // Tasks sitting in deques
+  atomic_size_t active;  // Tasks submitted but not finished
+  atomic_int sleepers;   // Workers blocked on work_cond
+  atomic_uint next;      // Round-robin target for outside submissions
+
+  pthread_mutex_t lock;
+  pthread_cond_t work_cond;
+  pthread_cond_t done_cond;
+  bool stop;
+};
+
+// Which pool/deque the current thread works for (NULL outside workers)
+static _Thread_local Pool *current_pool;
+static _Thread_local int current_index;
+
+// ============================================================================
+// Deque
+// ============================================================================
+
+static bool deque_push_back(PoolDeque *d, PoolTask task) {
+  pthread_mutex_lock(&d->lock);
+  if (d->count == d->cap) {
+    size_t new_cap = d->cap ? d->cap * 2 : 64;
+    PoolTask *tasks = malloc(new_cap * sizeof(PoolTask));
+    if (!tasks) {
+      pthread_mutex_unlock(&d->lock);
+      return false;
+    }
+    // Unwrap the ring into the new buffer
+    for (size_t i = 0; i < d->count; i++)
+      tasks[i] = d->tasks[(d->head + i) % d->cap];
+    free(d->tasks);
+    d->tasks = tasks;
+    d->cap = new_cap;
+    d->head = 0;
+  }
+  d->tasks[(d->head + d->count) % d->cap] = task;
+  d->count++;
+  pthread_mutex_unlock(&d->lock);
+  return true;
+}
+
+static bool deque_pop_back(PoolDeque *d, PoolTask *out) {
+  pthread_mutex_lock(&d->lock);
+  bool ok = d->count > 0;
+  if (ok) {
+    d->count--;
+    *out = d->tasks[(d->head + d->count) % d->cap];
+  }
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+static bool deque_pop_front(PoolDeque *d, PoolTask *out) {
+  pthread_mutex_lock(&d->lock);
+  bool ok = d->count > 0;
+  if (ok) {
+    *out = d->tasks[d->head];
+    d->head = (d->head + 1) % d->cap;
+    d->count--;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+static bool steal(Pool *pool, int self, PoolTask *out) {
+  for (int i = 1; i < pool->ndeques; i++) {
+    int victim = (self + i) % pool->ndeques;
+    if (deque_pop_front(&pool->deques[victim], out))
+      return true;
+  }
+  return false;
+}
+
+static void task_done(Pool *pool) {
+  if (atomic_fetch_sub(&pool->active, 1) == 1) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->done_cond);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+static void *worker_main(void *arg) {
+  PoolWorker *w = arg;
+  Pool *pool = w->pool;
+  current_pool = pool;
+  current_index = w->index;
+
+  while (1) {
+    PoolTask task;
+    if (deque_pop_back(&pool->deques[w->index], &task) ||
+        steal(pool, w->index, &task)) {
+      atomic_fetch_sub(&pool->queued, 1);
+      task.fn(task.arg);
+      task_done(pool);
+      continue;
+    }
+
+    // Nothing to do: sleep until something is queued or we're stopped
+    pthread_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->sleepers, 1);
+    while (atomic_load(&pool->queued) == 0 && !pool->stop)
+      pthread_cond_wait(&pool->work_cond, &pool->lock);
+    atomic_fetch_sub(&pool->sleepers, 1);
+    bool stop = pool->stop && atomic_load(&pool->queued) == 0;
+    pthread_mutex_unlock(&pool->lock);
+    if (stop)
+      break;
+  }
+  return NULL;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+int pool_default_threads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1)
+    n = 1;
+  if (n > POOL_MAX_THREADS)
+    n = POOL_MAX_THREADS;
+  return (int)n;
+}
+
+Pool *pool_create(int threads) {
+  if (threads < 1)
+    threads = 1;
+
+  Pool *pool = calloc(1, sizeof(Pool));
+  if (!pool)
+    return NULL;
+  pool->threads = calloc((size_t)threads, sizeof(pthread_t));
+  pool->workers = calloc((size_t)threads, sizeof(PoolWorker));
+  pool->deques = calloc((size_t)threads, sizeof(PoolDeque));
+  if (!pool->threads || !pool->workers || !pool->deques) {
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->deques);
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_cond, NULL);
+  pthread_cond_init(&pool->done_cond, NULL);
+  for (int i = 0; i < threads; i++)
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+  pool->ndeques = threads;
+
+  for (int i = 0; i < threads; i++) {
+    pool->workers[i] = (PoolWorker){.pool = pool, .index = i};
+    if (pthread_create(&pool->threads[i], NULL, worker_main,
+                       &pool->workers[i]) != 0)
+      break;
+    pool->nthreads++;
+  }
+
+  if (pool->nthreads == 0) {
+    pool_destroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+void pool_submit(Pool *pool, PoolTaskFn fn, void *arg) {
+  PoolTask task = {.fn = fn, .arg = arg};
+  int target = (current_pool == pool)
+                   ? current_index
+                   : (int)(atomic_fetch_add(&pool->next, 1) %
+                           (unsigned)pool->nthreads);
+
+  atomic_fetch_add(&pool->active, 1);
+  if (!deque_push_back(&pool->deques[target], task)) {
+    // Out of memory: run it inline rather than dropping it
+    fn(arg);
+    task_done(pool);
+    return;
+  }
+  atomic_fetch_add(&pool->queued, 1);
+
+  if (atomic_load(&pool->sleepers) > 0) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+void pool_wait(Pool *pool) {
+  pthread_mutex_lock(&pool->lock);
+  while (atomic_load(&pool->active) > 0)
+    pthread_cond_wait(&pool->done_cond, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_destroy(Pool *pool) {
+  if (!pool)
+    return;
+  pool_wait(pool);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->work_cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->nthreads; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  for (int i = 0; i < pool->ndeques; i++) {
+    pthread_mutex_destroy(&pool->deques[i].lock);
+    free(pool->deques[i].tasks);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->work_cond);
+  pthread_cond_destroy(&pool->done_cond);
+  free(pool->threads);
+  free(pool->workers);
+  free(pool->deques);
+  free(pool);
+}
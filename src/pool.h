@@ -0,0 +1,33 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// ============================================================================
+// Work-stealing thread pool
+// ============================================================================
+//
+// Each worker owns a deque: tasks submitted from a worker go to the back of
+// its own deque and are popped LIFO (depth-first, cache-warm), while idle
+// workers steal from the front of other deques (oldest, usually largest
+// subtrees). Tasks submitted from outside the pool are spread round-robin.
+
+typedef struct Pool Pool;
+typedef void (*PoolTaskFn)(void *arg);
+
+// Number of workers to use by default (online CPUs, clamped to 1..16)
+int pool_default_threads(void);
+
+// Returns NULL if threads could not be started
+Pool *pool_create(int threads);
+
+// Queues a task. Safe to call from inside a running task.
+void pool_submit(Pool *pool, PoolTaskFn fn, void *arg);
+
+// Blocks until every submitted task (including tasks they submitted) is done
+void pool_wait(Pool *pool);
+
+// Waits for outstanding tasks, then stops the workers
+void pool_destroy(Pool *pool);
+
+#endif // POOL_H
@@ -0,0 +1,320 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "postings.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define POSTINGS_MAGIC "TRYPOST1"
+#define POSTINGS_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t entries;
+  uint64_t pool_len;
+  uint64_t pool_hash;
+} PostingsHeader;
+
+// Ids sharing their high 16 bits; the low halves run from `start` to the
+// next block's start
+typedef struct {
+  uint16_t key;
+  uint16_t reserved;
+  uint32_t start;
+} PostingBlock;
+
+Z_VEC_GENERATE_IMPL(uint16_t, u16)
+Z_VEC_GENERATE_IMPL(PostingBlock, PostingBlock)
+
+typedef struct {
+  vec_PostingBlock blocks;
+  vec_u16 lows;
+} PostingList;
+
+struct Postings {
+  PostingList lists[256];
+};
+
+// ============================================================================
+// Building
+// ============================================================================
+
+static void list_push(PostingList *list, uint32_t id) {
+  uint16_t key = (uint16_t)(id >> 16);
+  if (list->blocks.length == 0 || vec_last_PostingBlock(&list->blocks)->key != key) {
+    vec_push_PostingBlock(&list->blocks,
+                          (PostingBlock){.key = key, .start = (uint32_t)list->lows.length});
+  }
+  vec_push_u16(&list->lows, (uint16_t)id);
+}
+
+void postings_add(Postings *p, uint32_t id, zstr_view lower) {
+  // Each byte once per name
+  uint64_t seen[4] = {0};
+  for (size_t i = 0; i < lower.len; i++) {
+    unsigned char c = (unsigned char)lower.data[i];
+    uint64_t bit = 1ULL << (c & 63);
+    if (seen[c >> 6] & bit)
+      continue;
+    seen[c >> 6] |= bit;
+    list_push(&p->lists[c], id);
+  }
+}
+
+Postings *postings_build(const EntryStore *store) {
+  Postings *p = calloc(1, sizeof(Postings));
+  if (!p)
+    return NULL;
+  for (size_t i = 0; i < entry_count(store); i++)
+    postings_add(p, (uint32_t)i, entry_lower_view(store, i));
+  return p;
+}
+
+void postings_free(Postings *p) {
+  if (!p)
+    return;
+  for (int c = 0; c < 256; c++) {
+    vec_free_PostingBlock(&p->lists[c].blocks);
+    vec_free_u16(&p->lists[c].lows);
+  }
+  free(p);
+}
+
+// ============================================================================
+// Intersection
+// ============================================================================
+
+// First index in [lo, hi) whose value is >= x: exponential steps from lo,
+// then a binary search, then a branchless count over the last few values
+static size_t gallop_u16(const uint16_t *a, size_t lo, size_t hi, uint16_t x) {
+  size_t step = 1;
+  while (lo + step < hi && a[lo + step] < x) {
+    lo += step;
+    step *= 2;
+  }
+  if (lo + step < hi)
+    hi = lo + step + 1;
+  while (hi - lo > 16) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (a[mid] < x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  size_t below = 0;
+  for (size_t i = lo; i < hi; i++)
+    below += a[i] < x;
+  return lo + below;
+}
+
+static size_t gallop_block(const PostingBlock *b, size_t lo, size_t hi, uint16_t key) {
+  size_t step = 1;
+  while (lo + step < hi && b[lo + step].key < key) {
+    lo += step;
+    step *= 2;
+  }
+  if (lo + step < hi)
+    hi = lo + step + 1;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (b[mid].key < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Keeps the ids of `ids` that are also in `list`
+static void intersect(vec_u32 *ids, const PostingList *list) {
+  const PostingBlock *blocks = list->blocks.data;
+  size_t nblocks = list->blocks.length;
+  const uint16_t *lows = list->lows.data;
+
+  size_t kept = 0, b = 0, at = 0;
+  for (size_t i = 0; i < ids->length && b < nblocks; i++) {
+    uint32_t id = ids->data[i];
+    uint16_t key = (uint16_t)(id >> 16);
+    if (blocks[b].key != key) {
+      b = gallop_block(blocks, b, nblocks, key);
+      if (b == nblocks)
+        break;
+      at = blocks[b].start;
+      if (blocks[b].key != key)
+        continue;
+    }
+    size_t end = b + 1 < nblocks ? blocks[b + 1].start : list->lows.length;
+    at = gallop_u16(lows, at, end, (uint16_t)id);
+    if (at < end && lows[at] == (uint16_t)id)
+      ids->data[kept++] = id;
+  }
+  ids->length = kept;
+}
+
+static size_t list_len(const PostingList *list) {
+  return list->lows.length;
+}
+
+void postings_candidates(const Postings *p, zstr_view query_lower, vec_u32 *out) {
+  vec_clear_u32(out);
+
+  // Distinct query bytes, shortest list first
+  const PostingList *lists[256];
+  size_t n = 0;
+  uint64_t seen[4] = {0};
+  for (size_t i = 0; i < query_lower.len; i++) {
+    unsigned char c = (unsigned char)query_lower.data[i];
+    uint64_t bit = 1ULL << (c & 63);
+    if (seen[c >> 6] & bit)
+      continue;
+    seen[c >> 6] |= bit;
+    const PostingList *list = &p->lists[c];
+    size_t at = n++;
+    while (at > 0 && list_len(lists[at - 1]) > list_len(list)) {
+      lists[at] = lists[at - 1];
+      at--;
+    }
+    lists[at] = list;
+  }
+  if (n == 0 || list_len(lists[0]) == 0)
+    return;
+
+  const PostingList *first = lists[0];
+  vec_reserve_u32(out, list_len(first));
+  for (size_t b = 0; b < first->blocks.length; b++) {
+    uint32_t high = (uint32_t)first->blocks.data[b].key << 16;
+    size_t end = b + 1 < first->blocks.length ? first->blocks.data[b + 1].start
+                                              : list_len(first);
+    for (size_t i = first->blocks.data[b].start; i < end; i++)
+      out->data[out->length++] = high | first->lows.data[i];
+  }
+  for (size_t i = 1; i < n && out->length > 0; i++)
+    intersect(out, lists[i]);
+}
+
+// ============================================================================
+// Persisted index
+// ============================================================================
+
+static uint64_t hash_pool(const char *s, size_t len) {
+  // Eight bytes at a time; only needs to tell a changed list apart
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ len;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t w;
+    memcpy(&w, s + i, 8);
+    h = (h ^ w) * 0xff51afd7ed558ccdULL;
+    h ^= h >> 32;
+  }
+  for (; i < len; i++)
+    h = (h ^ (unsigned char)s[i]) * 0x100000001b3ULL;
+  return h;
+}
+
+static PostingsHeader header_for(const EntryStore *store) {
+  PostingsHeader hdr = {.version = POSTINGS_VERSION,
+                        .entries = (uint32_t)entry_count(store),
+                        .pool_len = zstr_len(&store->lower_pool),
+                        .pool_hash = hash_pool(zstr_cstr(&store->lower_pool),
+                                               zstr_len(&store->lower_pool))};
+  memcpy(hdr.magic, POSTINGS_MAGIC, 8);
+  return hdr;
+}
+
+static Postings *postings_load(const char *path, const PostingsHeader *want) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+  struct stat sb;
+  if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(PostingsHeader)) {
+    close(fd);
+    return NULL;
+  }
+  size_t len = (size_t)sb.st_size;
+  char *file = malloc(len);
+  bool ok = file && read(fd, file, len) == (ssize_t)len;
+  close(fd);
+  if (!ok || memcmp(file, want, sizeof(PostingsHeader)) != 0) {
+    free(file);
+    return NULL;
+  }
+
+  Postings *p = calloc(1, sizeof(Postings));
+  size_t off = sizeof(PostingsHeader);
+  for (int c = 0; p && c < 256; c++) {
+    uint32_t counts[2];
+    if (len - off < sizeof(counts))
+      break;
+    memcpy(counts, file + off, sizeof(counts));
+    off += sizeof(counts);
+    size_t block_bytes = (size_t)counts[0] * sizeof(PostingBlock);
+    size_t low_bytes = (size_t)counts[1] * sizeof(uint16_t);
+    if (len - off < block_bytes || len - off - block_bytes < low_bytes)
+      break;
+
+    PostingList *list = &p->lists[c];
+    if (counts[0] > 0) {
+      vec_reserve_PostingBlock(&list->blocks, counts[0]);
+      memcpy(list->blocks.data, file + off, block_bytes);
+      list->blocks.length = counts[0];
+    }
+    off += block_bytes;
+    if (counts[1] > 0) {
+      vec_reserve_u16(&list->lows, counts[1]);
+      memcpy(list->lows.data, file + off, low_bytes);
+      list->lows.length = counts[1];
+    }
+    off += low_bytes;
+  }
+  free(file);
+
+  // A truncated or padded file is rebuilt
+  if (p && off != len) {
+    postings_free(p);
+    return NULL;
+  }
+  return p;
+}
+
+static void postings_save(const Postings *p, const char *path, const PostingsHeader *hdr) {
+  zstr buf = zstr_init();
+  zstr_cat_len(&buf, (const char *)hdr, sizeof(*hdr));
+  for (int c = 0; c < 256; c++) {
+    const PostingList *list = &p->lists[c];
+    uint32_t counts[2] = {(uint32_t)list->blocks.length, (uint32_t)list->lows.length};
+    zstr_cat_len(&buf, (const char *)counts, sizeof(counts));
+    if (counts[0] > 0)
+      zstr_cat_len(&buf, (const char *)list->blocks.data,
+                   list->blocks.length * sizeof(PostingBlock));
+    if (counts[1] > 0)
+      zstr_cat_len(&buf, (const char *)list->lows.data,
+                   list->lows.length * sizeof(uint16_t));
+  }
+
+  write_file_atomic(path, zstr_cstr(&buf), zstr_len(&buf), NULL, 0);
+  zstr_free(&buf);
+}
+
+void postings_scan(EntryStore *store, const char *root) {
+  if (store->postings || entry_count(store) < POSTINGS_MIN_ENTRIES)
+    return;
+
+  PostingsHeader hdr = header_for(store);
+  Z_CLEANUP(zstr_free) zstr path = join_path(root, POSTINGS_FILE);
+  store->postings = postings_load(zstr_cstr(&path), &hdr);
+  if (store->postings)
+    return;
+
+  store->postings = postings_build(store);
+  if (store->postings)
+    postings_save(store->postings, zstr_cstr(&path), &hdr);
+}
@@ -0,0 +1,57 @@
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#include "entries.h"
+
+// ============================================================================
+// Character postings index
+// ============================================================================
+//
+// Large stores (shared build hosts with hundreds of thousands of tries or
+// nested directories) shouldn't be scanned in full on every keystroke. A
+// fuzzy match needs every query character somewhere in the name, in order,
+// so the entries containing all of them are a complete candidate set.
+//
+// Grams of adjacent characters would prune harder but can't be used: "cnp"
+// matches "connection-pool" without any of its bigrams or trigrams being in
+// the name.
+//
+// For every byte value, the index keeps the sorted ids of the entries whose
+// lowercase name contains it. Ids are split into 16-bit blocks (high half as
+// the block key, low halves stored as uint16_t), which halves the size of
+// the lists. Intersections start from the shortest list and gallop through
+// the others.
+//
+// The index is persisted in <tries>/.try_postings:
+//
+//   header:  "TRYPOST1" magic, uint32 version, uint32 entries,
+//            uint64 name pool length, uint64 name pool hash   (32 bytes)
+//   lists:   for each of the 256 bytes, uint32 block count,
+//            uint32 id count, the blocks (uint16 key, uint16 reserved,
+//            uint32 first id index) and the low halves (uint16 each)
+//
+// It's only reused when the scanned names are byte-for-byte the same
+// (length and hash of the lowercase pool), so it never needs updating in
+// place.
+
+#define POSTINGS_FILE ".try_postings"
+#define POSTINGS_MIN_ENTRIES 20000
+
+// Index of the entries of a store (or NULL when out of memory)
+Postings *postings_build(const EntryStore *store);
+
+// Indexes the newest entry of the index's store
+void postings_add(Postings *p, uint32_t id, zstr_view lower);
+
+// Attaches an index to a store of at least POSTINGS_MIN_ENTRIES entries,
+// loading root's persisted one if it matches the names, and building and
+// saving a fresh one otherwise
+void postings_scan(EntryStore *store, const char *root);
+
+// Replaces `out` with the sorted ids of the entries whose name contains every
+// byte of the (lowercase) query
+void postings_candidates(const Postings *p, zstr_view query_lower, vec_u32 *out);
+
+void postings_free(Postings *p);
+
+#endif // POSTINGS_H
@@ -0,0 +1,338 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "preview.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NO_ENTRY UINT32_MAX
+
+typedef struct {
+  uint32_t entry;      // NO_ENTRY if the slot is free
+  uint64_t used;       // LRU clock of the last preview_get()
+  Preview preview;
+} PreviewSlot;
+
+typedef struct {
+  uint32_t entry;
+  Preview preview;
+} PreviewResult;
+
+Z_VEC_GENERATE_IMPL(PreviewResult, PreviewResult)
+
+struct PreviewLoader {
+  bool sync;
+
+  // Cache (caller's thread only)
+  PreviewSlot slots[PREVIEW_CACHE_SIZE];
+  uint64_t clock;
+
+  pthread_t thread;
+  bool started;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+
+  // Guarded by lock
+  bool stop;
+  uint32_t want;       // Requested entry, NO_ENTRY if none
+  zstr want_path;
+  uint32_t loading;    // Entry being read, NO_ENTRY if idle
+  vec_PreviewResult results;
+};
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+static void preview_free(Preview *p) {
+  zstr *s;
+  vec_foreach(&p->files, s) zstr_free(s);
+  vec_foreach(&p->readme, s) zstr_free(s);
+  vec_free_zstr(&p->files);
+  vec_free_zstr(&p->readme);
+  zstr_free(&p->readme_name);
+  *p = (Preview){0};
+}
+
+// Names and README text go straight to the terminal: replace anything that
+// could be taken as a control sequence
+static zstr sanitized(const char *s, size_t len) {
+  zstr out = zstr_init();
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char)s[i];
+    if (c == '\t') {
+      zstr_cat(&out, "  ");
+    } else if (c < 0x20 || c == 0x7f) {
+      zstr_push(&out, '?');
+    } else {
+      zstr_push(&out, (char)c);
+    }
+  }
+  return out;
+}
+
+static int compare_listing(const void *a, const void *b) {
+  const char *sa = zstr_cstr((const zstr *)a);
+  const char *sb = zstr_cstr((const zstr *)b);
+  bool da = sa[strlen(sa) - 1] == '/';
+  bool db = sb[strlen(sb) - 1] == '/';
+  if (da != db)
+    return da ? -1 : 1;
+  return strcmp(sa, sb);
+}
+
+// The README to show: shortest "readme*" name, so README.md beats
+// README.old.md
+static bool better_readme(const char *name, const zstr *current) {
+  if (strncasecmp(name, "readme", 6) != 0)
+    return false;
+  return zstr_len(current) == 0 || strlen(name) < zstr_len(current);
+}
+
+static void preview_load(const char *path, Preview *out) {
+  *out = (Preview){0};
+
+  int dirfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirfd < 0)
+    return;
+
+  // One pass over the directory collects the listing and finds the README
+  int scan_fd = dup(dirfd);
+  DIR *d = scan_fd >= 0 ? fdopendir(scan_fd) : NULL;
+  if (!d) {
+    if (scan_fd >= 0)
+      close(scan_fd);
+    close(dirfd);
+    return;
+  }
+  struct dirent *de;
+  while ((de = readdir(d)) != NULL) {
+    const char *entry = de->d_name;
+    if (entry[0] == '.')
+      continue;
+    if (out->files.length >= PREVIEW_MAX_FILES) {
+      out->more = true;
+      break;
+    }
+
+    bool is_dir = de->d_type == DT_DIR;
+    if (de->d_type == DT_UNKNOWN || de->d_type == DT_LNK) {
+      struct stat sb;
+      is_dir = fstatat(dirfd, entry, &sb, 0) == 0 && S_ISDIR(sb.st_mode);
+    }
+
+    zstr item = sanitized(entry, strlen(entry));
+    if (is_dir) {
+      zstr_push(&item, '/');
+    } else if (better_readme(entry, &out->readme_name)) {
+      zstr_free(&out->readme_name);
+      out->readme_name = zstr_from(entry);
+    }
+    vec_push_zstr(&out->files, item);
+  }
+  closedir(d);
+
+  if (out->files.length > 1) {
+    qsort(out->files.data, out->files.length, sizeof(zstr), compare_listing);
+  }
+
+  if (zstr_len(&out->readme_name) > 0) {
+    char buf[PREVIEW_README_BYTES];
+    ssize_t n = -1;
+    int fd = openat(dirfd, zstr_cstr(&out->readme_name), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      n = read(fd, buf, sizeof(buf));
+      close(fd);
+    }
+    // Split into lines; a line cut by the byte limit is still shown
+    for (ssize_t start = 0, i = 0; n > 0 && i <= n; i++) {
+      if (i == n || buf[i] == '\n') {
+        size_t len = (size_t)(i - start);
+        if (len > 0 && buf[start + len - 1] == '\r')
+          len--;
+        if (i < n || len > 0)
+          vec_push_zstr(&out->readme, sanitized(buf + start, len));
+        if (out->readme.length >= PREVIEW_README_LINES)
+          break;
+        start = i + 1;
+      }
+    }
+  }
+  close(dirfd);
+}
+
+// ============================================================================
+// Loader thread
+// ============================================================================
+
+static void deadline_after_ms(struct timespec *ts, int ms) {
+  clock_gettime(CLOCK_REALTIME, ts);
+  ts->tv_nsec += (long)ms * 1000000L;
+  ts->tv_sec += ts->tv_nsec / 1000000000L;
+  ts->tv_nsec %= 1000000000L;
+}
+
+static void *loader_main(void *arg) {
+  PreviewLoader *pl = arg;
+
+  pthread_mutex_lock(&pl->lock);
+  while (!pl->stop) {
+    if (pl->want == NO_ENTRY) {
+      pthread_cond_wait(&pl->wake, &pl->lock);
+      continue;
+    }
+
+    // Debounce: start over whenever the request changes during the wait
+    uint32_t entry = pl->want;
+    struct timespec deadline;
+    deadline_after_ms(&deadline, PREVIEW_DEBOUNCE_MS);
+    int rc = 0;
+    while (!pl->stop && pl->want == entry && rc != ETIMEDOUT)
+      rc = pthread_cond_timedwait(&pl->wake, &pl->lock, &deadline);
+    if (pl->stop || pl->want != entry)
+      continue;
+
+    zstr path = pl->want_path;
+    pl->want_path = zstr_init();
+    pl->want = NO_ENTRY;
+    pl->loading = entry;
+    pthread_mutex_unlock(&pl->lock);
+
+    PreviewResult result = {.entry = entry};
+    preview_load(zstr_cstr(&path), &result.preview);
+    zstr_free(&path);
+
+    pthread_mutex_lock(&pl->lock);
+    pl->loading = NO_ENTRY;
+    vec_push_PreviewResult(&pl->results, result);
+  }
+  pthread_mutex_unlock(&pl->lock);
+  return NULL;
+}
+
+// ============================================================================
+// Cache
+// ============================================================================
+
+// Stores a preview, evicting the least recently used slot
+static const Preview *cache_put(PreviewLoader *pl, uint32_t entry, Preview preview) {
+  PreviewSlot *victim = &pl->slots[0];
+  for (size_t i = 0; i < PREVIEW_CACHE_SIZE; i++) {
+    PreviewSlot *slot = &pl->slots[i];
+    if (slot->entry == entry || slot->entry == NO_ENTRY) {
+      victim = slot;
+      break;
+    }
+    if (slot->used < victim->used)
+      victim = slot;
+  }
+  if (victim->entry != NO_ENTRY)
+    preview_free(&victim->preview);
+  victim->entry = entry;
+  victim->used = ++pl->clock;
+  victim->preview = preview;
+  return &victim->preview;
+}
+
+PreviewLoader *preview_loader_new(bool sync) {
+  PreviewLoader *pl = calloc(1, sizeof(PreviewLoader));
+  if (!pl)
+    return NULL;
+  pl->sync = sync;
+  for (size_t i = 0; i < PREVIEW_CACHE_SIZE; i++)
+    pl->slots[i].entry = NO_ENTRY;
+  pl->want = NO_ENTRY;
+  pl->loading = NO_ENTRY;
+  pthread_mutex_init(&pl->lock, NULL);
+  pthread_cond_init(&pl->wake, NULL);
+  return pl;
+}
+
+const Preview *preview_get(PreviewLoader *pl, uint32_t entry, const char *path) {
+  if (!pl)
+    return NULL;
+
+  for (size_t i = 0; i < PREVIEW_CACHE_SIZE; i++) {
+    if (pl->slots[i].entry == entry) {
+      pl->slots[i].used = ++pl->clock;
+      return &pl->slots[i].preview;
+    }
+  }
+
+  if (pl->sync) {
+    Preview preview;
+    preview_load(path, &preview);
+    return cache_put(pl, entry, preview);
+  }
+
+  pthread_mutex_lock(&pl->lock);
+  if (pl->want != entry && pl->loading != entry) {
+    pl->want = entry;
+    zstr_free(&pl->want_path);
+    pl->want_path = zstr_from(path);
+    if (!pl->started)
+      pl->started = pthread_create(&pl->thread, NULL, loader_main, pl) == 0;
+    pthread_cond_signal(&pl->wake);
+  }
+  pthread_mutex_unlock(&pl->lock);
+  return NULL;
+}
+
+bool preview_poll(PreviewLoader *pl) {
+  if (!pl)
+    return false;
+
+  pthread_mutex_lock(&pl->lock);
+  bool arrived = pl->results.length > 0;
+  PreviewResult *r;
+  vec_foreach(&pl->results, r) cache_put(pl, r->entry, r->preview);
+  vec_clear_PreviewResult(&pl->results);
+  pthread_mutex_unlock(&pl->lock);
+  return arrived;
+}
+
+bool preview_busy(PreviewLoader *pl) {
+  if (!pl)
+    return false;
+  pthread_mutex_lock(&pl->lock);
+  bool busy = pl->want != NO_ENTRY || pl->loading != NO_ENTRY ||
+              pl->results.length > 0;
+  pthread_mutex_unlock(&pl->lock);
+  return busy;
+}
+
+void preview_loader_free(PreviewLoader *pl) {
+  if (!pl)
+    return;
+
+  pthread_mutex_lock(&pl->lock);
+  pl->stop = true;
+  pthread_cond_signal(&pl->wake);
+  pthread_mutex_unlock(&pl->lock);
+  if (pl->started)
+    pthread_join(pl->thread, NULL);
+
+  PreviewResult *r;
+  vec_foreach(&pl->results, r) preview_free(&r->preview);
+  vec_free_PreviewResult(&pl->results);
+  for (size_t i = 0; i < PREVIEW_CACHE_SIZE; i++) {
+    if (pl->slots[i].entry != NO_ENTRY)
+      preview_free(&pl->slots[i].preview);
+  }
+  zstr_free(&pl->want_path);
+  pthread_cond_destroy(&pl->wake);
+  pthread_mutex_destroy(&pl->lock);
+  free(pl);
+}
@@ -0,0 +1,52 @@
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include "tui.h" // vec_zstr
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Directory previews
+// ============================================================================
+//
+// A preview is a short listing of a try directory plus the first lines of
+// its README. Previews are loaded by a background thread from one opened
+// directory fd (one directory read, at most PREVIEW_README_BYTES of README)
+// and kept in a small LRU cache owned by the caller's thread. Requests are
+// debounced: the loader waits until the wanted entry has been stable for
+// PREVIEW_DEBOUNCE_MS, so holding an arrow key never queues disk reads.
+
+#define PREVIEW_CACHE_SIZE 32
+#define PREVIEW_MAX_FILES 256
+#define PREVIEW_README_BYTES 2048
+#define PREVIEW_README_LINES 24
+#define PREVIEW_DEBOUNCE_MS 60
+
+typedef struct {
+  vec_zstr files;      // Sorted listing, directories first with a trailing '/'
+  bool more;           // The directory has more than PREVIEW_MAX_FILES entries
+  zstr readme_name;    // Empty if there is no README
+  vec_zstr readme;     // First lines, control characters replaced
+} Preview;
+
+typedef struct PreviewLoader PreviewLoader;
+
+// With sync set, loads happen inline in preview_get() (deterministic output
+// for tests)
+PreviewLoader *preview_loader_new(bool sync);
+
+// Returns the cached preview of an entry, or NULL after asking the loader
+// to read its directory at path. Only the most recent request is kept.
+const Preview *preview_get(PreviewLoader *pl, uint32_t entry, const char *path);
+
+// Moves finished loads into the cache. Returns true if any arrived.
+bool preview_poll(PreviewLoader *pl);
+
+// True while a request is pending or loading
+bool preview_busy(PreviewLoader *pl);
+
+// Stops the loader and frees pl (NULL is ignored)
+void preview_loader_free(PreviewLoader *pl);
+
+#endif // PREVIEW_H
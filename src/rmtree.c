@@ -0,0 +1,248 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "rmtree.h"
+#include "pool.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A directory being removed. It stays open until all of its subdirectories
+// are gone, so children are opened and removed relative to its fd.
+typedef struct RmNode {
+  struct RmNode *parent; // NULL for top-level entries
+  RmTree *rt;
+  int fd;
+  atomic_size_t pending; // Subdirectories not yet removed + 1 for the scan
+  char name[];
+} RmNode;
+
+struct RmTree {
+  Pool *pool;
+  int rootfd;
+  atomic_size_t files;
+  atomic_size_t dirs;
+  atomic_size_t errors;
+  atomic_int first_errno;
+  atomic_size_t roots_left;
+  struct rlimit saved_fds; // Soft limit to restore, rlim_cur 0 if untouched
+};
+
+static bool is_safe_name(const char *name) {
+  return *name && strchr(name, '/') == NULL && strcmp(name, ".") != 0 &&
+         strcmp(name, "..") != 0;
+}
+
+static void record_error(RmTree *rt, int err) {
+  int expected = 0;
+  atomic_compare_exchange_strong(&rt->first_errno, &expected, err);
+  atomic_fetch_add(&rt->errors, 1);
+}
+
+static int parent_fd(const RmNode *node) {
+  return node->parent ? node->parent->fd : node->rt->rootfd;
+}
+
+static RmNode *node_new(RmTree *rt, RmNode *parent, const char *name) {
+  size_t len = strlen(name);
+  RmNode *node = malloc(sizeof(RmNode) + len + 1);
+  if (!node)
+    return NULL;
+  node->parent = parent;
+  node->rt = rt;
+  node->fd = -1;
+  atomic_init(&node->pending, 1);
+  memcpy(node->name, name, len + 1);
+  return node;
+}
+
+// Drops one reference; the last one removes the (now empty) directory and
+// walks up, releasing the parent in turn
+static void node_release(RmNode *node, bool remove_dir) {
+  while (node && atomic_fetch_sub(&node->pending, 1) == 1) {
+    RmTree *rt = node->rt;
+    RmNode *parent = node->parent;
+
+    if (node->fd >= 0)
+      close(node->fd);
+    if (remove_dir) {
+      if (unlinkat(parent_fd(node), node->name, AT_REMOVEDIR) == 0)
+        atomic_fetch_add(&rt->dirs, 1);
+      else if (errno != ENOENT)
+        record_error(rt, errno);
+    }
+    free(node);
+
+    if (!parent)
+      atomic_fetch_sub(&rt->roots_left, 1);
+    node = parent;
+    remove_dir = true;
+  }
+}
+
+static void unlink_entry(RmTree *rt, int dirfd, const char *name) {
+  if (unlinkat(dirfd, name, 0) == 0)
+    atomic_fetch_add(&rt->files, 1);
+  else if (errno != ENOENT)
+    record_error(rt, errno);
+}
+
+static void scan_task(void *arg) {
+  RmNode *node = arg;
+  RmTree *rt = node->rt;
+  int pfd = parent_fd(node);
+
+  node->fd = openat(pfd, node->name,
+                    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (node->fd < 0) {
+    if (errno == ENOTDIR || errno == ELOOP) {
+      // Not a directory (or a symlink to one): remove the entry itself
+      unlink_entry(rt, pfd, node->name);
+    } else if (errno != ENOENT) {
+      record_error(rt, errno);
+    }
+    node_release(node, false);
+    return;
+  }
+
+  // fdopendir takes ownership of its fd; keep ours for the children
+  int scan_fd = dup(node->fd);
+  DIR *d = scan_fd >= 0 ? fdopendir(scan_fd) : NULL;
+  if (!d) {
+    record_error(rt, errno);
+    if (scan_fd >= 0)
+      close(scan_fd);
+    node_release(node, true);
+    return;
+  }
+
+  struct dirent *de;
+  while ((de = readdir(d)) != NULL) {
+    const char *name = de->d_name;
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+      continue;
+
+    bool is_dir = de->d_type == DT_DIR;
+    if (de->d_type == DT_UNKNOWN) {
+      struct stat sb;
+      is_dir = fstatat(node->fd, name, &sb, AT_SYMLINK_NOFOLLOW) == 0 &&
+               S_ISDIR(sb.st_mode);
+    }
+
+    if (!is_dir) {
+      unlink_entry(rt, node->fd, name);
+      continue;
+    }
+
+    RmNode *child = node_new(rt, node, name);
+    if (!child) {
+      record_error(rt, ENOMEM);
+      continue;
+    }
+    atomic_fetch_add(&node->pending, 1);
+    pool_submit(rt->pool, scan_task, child);
+  }
+  closedir(d);
+
+  node_release(node, true);
+}
+
+// Deep trees keep one fd open per directory level per worker. The limit is
+// only raised for the duration of the delete: the shell script and whatever
+// it execs afterwards inherit the process limits.
+static void raise_fd_limit(RmTree *rt) {
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+    struct rlimit saved = rl;
+    rl.rlim_cur = rl.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &rl) == 0)
+      rt->saved_fds = saved;
+  }
+}
+
+static void restore_fd_limit(const RmTree *rt) {
+  struct rlimit rl;
+  // Leave it alone if someone else changed it in the meantime
+  if (rt->saved_fds.rlim_cur != 0 && getrlimit(RLIMIT_NOFILE, &rl) == 0 &&
+      rl.rlim_cur == rl.rlim_max) {
+    rl.rlim_cur = rt->saved_fds.rlim_cur;
+    setrlimit(RLIMIT_NOFILE, &rl);
+  }
+}
+
+RmTree *rmtree_start(int dirfd, const char *const *names, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (!is_safe_name(names[i])) {
+      errno = EINVAL;
+      return NULL;
+    }
+  }
+
+  RmTree *rt = calloc(1, sizeof(RmTree));
+  if (!rt)
+    return NULL;
+  rt->rootfd = dirfd == AT_FDCWD
+                   ? open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+                   : fcntl(dirfd, F_DUPFD_CLOEXEC, 0);
+  if (rt->rootfd < 0) {
+    free(rt);
+    return NULL;
+  }
+  rt->pool = pool_create(pool_default_threads());
+  if (!rt->pool) {
+    close(rt->rootfd);
+    free(rt);
+    return NULL;
+  }
+  raise_fd_limit(rt);
+
+  atomic_init(&rt->roots_left, count);
+  for (size_t i = 0; i < count; i++) {
+    RmNode *node = node_new(rt, NULL, names[i]);
+    if (!node) {
+      record_error(rt, ENOMEM);
+      atomic_fetch_sub(&rt->roots_left, 1);
+      continue;
+    }
+    pool_submit(rt->pool, scan_task, node);
+  }
+  return rt;
+}
+
+void rmtree_progress(RmTree *rt, RmTreeProgress *out) {
+  out->files = atomic_load(&rt->files);
+  out->dirs = atomic_load(&rt->dirs);
+  out->errors = atomic_load(&rt->errors);
+  out->first_errno = atomic_load(&rt->first_errno);
+  out->done = atomic_load(&rt->roots_left) == 0;
+}
+
+int rmtree_finish(RmTree *rt) {
+  pool_destroy(rt->pool);
+  close(rt->rootfd);
+  restore_fd_limit(rt);
+  int err = atomic_load(&rt->first_errno);
+  free(rt);
+  if (err) {
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
+int rmtree_remove(int dirfd, const char *const *names, size_t count) {
+  RmTree *rt = rmtree_start(dirfd, names, count);
+  if (!rt)
+    return -1;
+  return rmtree_finish(rt);
+}
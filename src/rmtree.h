@@ -0,0 +1,40 @@
+#ifndef RMTREE_H
+#define RMTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// Parallel recursive delete
+// ============================================================================
+//
+// Removes entries of one directory (the tries root) like `rm -rf`, using
+// openat/unlinkat on directory fds and a work-stealing pool with one task per
+// subdirectory. Symlinks are never followed (O_NOFOLLOW): a symlink is
+// unlinked, not descended into, so nothing outside the given directory can be
+// touched. Names must be plain entries: no '/', not "." or "..".
+
+typedef struct RmTree RmTree;
+
+typedef struct {
+  size_t files;       // Non-directories unlinked
+  size_t dirs;        // Directories removed
+  size_t errors;
+  int first_errno;    // 0 if no errors
+  bool done;
+} RmTreeProgress;
+
+// Starts removing names inside dirfd in the background (dirfd is dup'd).
+// Returns NULL with errno = EINVAL if a name is unsafe.
+RmTree *rmtree_start(int dirfd, const char *const *names, size_t count);
+
+void rmtree_progress(RmTree *rt, RmTreeProgress *out);
+
+// Waits for completion and frees rt. Returns 0 if everything was removed
+// (missing entries count as removed), -1 with errno of the first error.
+int rmtree_finish(RmTree *rt);
+
+// Synchronous rmtree_start + rmtree_finish
+int rmtree_remove(int dirfd, const char *const *names, size_t count);
+
+#endif // RMTREE_H
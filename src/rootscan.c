@@ -0,0 +1,164 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "rootscan.h"
+#include "postings.h"
+#include "sizes.h"
+#include "treeindex.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef struct {
+  RootScan *scan;
+  zstr root;
+  EntryStore store;    // Single-root result
+  bool done;           // Guarded by lock
+  bool merged;         // Caller's thread only
+} RootJob;
+
+struct RootScan {
+  pthread_mutex_t lock;
+  pthread_cond_t finished;
+  int refs;            // Caller's handle plus one per running thread
+  size_t pending;      // Roots still being scanned
+  size_t ready;        // Finished roots not merged yet
+  time_t now;
+  int depth;
+  size_t count;
+  RootJob *jobs;
+};
+
+// Drops a reference, called with the lock held (and releases it). The last
+// one frees the scan.
+static void scan_release(RootScan *rs) {
+  bool last = --rs->refs == 0;
+  pthread_mutex_unlock(&rs->lock);
+  if (!last)
+    return;
+
+  for (size_t i = 0; i < rs->count; i++) {
+    entry_store_free(&rs->jobs[i].store);
+    zstr_free(&rs->jobs[i].root);
+  }
+  free(rs->jobs);
+  pthread_cond_destroy(&rs->finished);
+  pthread_mutex_destroy(&rs->lock);
+  free(rs);
+}
+
+static void scan_root(RootJob *job) {
+  RootScan *rs = job->scan;
+  EntryStore store = {0};
+  entry_store_scan(&store, zstr_cstr(&job->root), rs->now);
+  sizes_load(&store);
+  tree_index_scan(&store, rs->depth);
+  postings_scan(&store, zstr_cstr(&job->root));
+
+  pthread_mutex_lock(&rs->lock);
+  job->store = store;
+  job->done = true;
+  rs->pending--;
+  rs->ready++;
+  pthread_cond_broadcast(&rs->finished);
+}
+
+static void *scan_main(void *arg) {
+  RootJob *job = arg;
+  scan_root(job);
+  scan_release(job->scan);
+  return NULL;
+}
+
+RootScan *root_scan_start(const EntryStore *store, int depth) {
+  RootScan *rs = calloc(1, sizeof(RootScan));
+  if (!rs)
+    return NULL;
+  rs->count = store->roots.length;
+  rs->jobs = calloc(rs->count ? rs->count : 1, sizeof(RootJob));
+  if (!rs->jobs) {
+    free(rs);
+    return NULL;
+  }
+  pthread_mutex_init(&rs->lock, NULL);
+  pthread_cond_init(&rs->finished, NULL);
+  rs->refs = 1;
+  rs->pending = rs->count;
+  rs->now = store->now;
+  rs->depth = depth;
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  for (size_t i = 0; i < rs->count; i++) {
+    RootJob *job = &rs->jobs[i];
+    job->scan = rs;
+    job->root = zstr_dup(&store->roots.data[i]);
+
+    pthread_mutex_lock(&rs->lock);
+    rs->refs++;
+    pthread_mutex_unlock(&rs->lock);
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, scan_main, job) != 0) {
+      // No thread: scan inline
+      scan_root(job);
+      scan_release(rs);
+    }
+  }
+  pthread_attr_destroy(&attr);
+  return rs;
+}
+
+void root_scan_wait(RootScan *rs, bool all) {
+  if (!rs)
+    return;
+  pthread_mutex_lock(&rs->lock);
+  while (rs->pending > 0 && (all || rs->ready == 0))
+    pthread_cond_wait(&rs->finished, &rs->lock);
+  pthread_mutex_unlock(&rs->lock);
+}
+
+bool root_scan_poll(RootScan *rs, EntryStore *store) {
+  if (!rs)
+    return false;
+
+  bool merged = false;
+  for (size_t i = 0; i < rs->count; i++) {
+    RootJob *job = &rs->jobs[i];
+    if (job->merged)
+      continue;
+    pthread_mutex_lock(&rs->lock);
+    bool done = job->done;
+    if (done)
+      rs->ready--;
+    pthread_mutex_unlock(&rs->lock);
+    if (!done)
+      continue;
+
+    // The thread is finished with the job once done is set
+    entry_store_merge(store, &job->store, (uint32_t)i);
+    entry_store_free(&job->store);
+    job->merged = true;
+    merged = true;
+  }
+  return merged;
+}
+
+size_t root_scan_pending(RootScan *rs) {
+  if (!rs)
+    return 0;
+  pthread_mutex_lock(&rs->lock);
+  size_t pending = rs->pending;
+  pthread_mutex_unlock(&rs->lock);
+  return pending;
+}
+
+void root_scan_free(RootScan *rs) {
+  if (!rs)
+    return;
+  pthread_mutex_lock(&rs->lock);
+  scan_release(rs);
+}
@@ -0,0 +1,40 @@
+#ifndef ROOTSCAN_H
+#define ROOTSCAN_H
+
+#include "entries.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// Multi-root scanning
+// ============================================================================
+//
+// Each tries root is scanned on its own thread: directory listing, access
+// history, size cache and nested index are all per root, so a slow root (a
+// network mount, a cold disk) doesn't hold up the others. Finished roots are
+// merged into the caller's store as they complete, tagged with their root id.
+//
+// The threads are detached and share a reference-counted handle, so
+// root_scan_free() returns immediately even if a root never answers.
+
+typedef struct RootScan RootScan;
+
+// Starts scanning store->roots (declared with entry_store_add_root()),
+// nesting depth levels deep (see treeindex.h)
+RootScan *root_scan_start(const EntryStore *store, int depth);
+
+// Blocks until every root is scanned, or with all unset until at least one
+// finished root is waiting to be merged
+void root_scan_wait(RootScan *rs, bool all);
+
+// Merges finished roots into the store. Returns true if any were merged.
+bool root_scan_poll(RootScan *rs, EntryStore *store);
+
+// Number of roots still being scanned
+size_t root_scan_pending(RootScan *rs);
+
+// Releases the caller's handle (NULL is ignored); unfinished roots are
+// dropped when their thread ends
+void root_scan_free(RootScan *rs);
+
+#endif // ROOTSCAN_H
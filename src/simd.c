@@ -0,0 +1,476 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define SIMD_ARM 1
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+static void lower_scalar(char *s, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if ((unsigned char)(s[i] - 'A') < 26)
+      s[i] = (char)(s[i] + ('a' - 'A'));
+  }
+}
+
+static size_t plain_span_scalar(const char *s, size_t len) {
+  size_t i = 0;
+  while (i < len && (unsigned char)s[i] < 0x80 && s[i] != '\033')
+    i++;
+  return i;
+}
+
+static uint64_t charset_scan_scalar(const SimdCharset *cs, const char *s, size_t len) {
+  uint64_t found = 0;
+  for (size_t i = 0; i < len; i++)
+    found |= cs->bit[(unsigned char)s[i]];
+  return found;
+}
+
+static const char *find_scalar(const char *hay, size_t n, const char *needle, size_t m) {
+  if (m == 0)
+    return hay;
+  return memmem(hay, n, needle, m);
+}
+
+SimdKernels simd = {
+    .level = SIMD_SCALAR,
+    .lower = lower_scalar,
+    .plain_span = plain_span_scalar,
+    .charset_scan = charset_scan_scalar,
+    .find = find_scalar,
+};
+
+void simd_charset_init(SimdCharset *cs, const char *bytes, size_t len) {
+  memset(cs, 0, sizeof(*cs));
+  for (size_t i = 0; i < len && cs->count < 64; i++) {
+    unsigned char c = (unsigned char)bytes[i];
+    if (c == 0 || cs->bit[c])
+      continue;
+    cs->bit[c] = 1ULL << cs->count;
+    cs->bytes[cs->count++] = c;
+  }
+}
+
+// Candidates for a substring at every position of a block are found by
+// comparing the needle's first and last bytes against the block and the
+// block m - 1 bytes further; only those get a full comparison. Positions
+// too close to the end for a whole block go to the scalar search.
+
+#ifdef SIMD_X86
+
+// ============================================================================
+// SSE4.2
+// ============================================================================
+
+// Letters are the bytes that land below -128 + 26 once shifted by 128 - 'A'
+#define LOWER_SHIFT ((char)(128 - 'A'))
+#define LOWER_BOUND ((char)(-128 + 26))
+
+TARGET("sse4.2") static void lower_sse42(char *s, size_t len) {
+  const __m128i shift = _mm_set1_epi8(LOWER_SHIFT);
+  const __m128i bound = _mm_set1_epi8(LOWER_BOUND);
+  const __m128i flip = _mm_set1_epi8('a' - 'A');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    __m128i upper = _mm_cmplt_epi8(_mm_add_epi8(v, shift), bound);
+    _mm_storeu_si128((__m128i *)(s + i), _mm_add_epi8(v, _mm_and_si128(upper, flip)));
+  }
+  lower_scalar(s + i, len - i);
+}
+
+TARGET("sse4.2") static size_t plain_span_sse42(const char *s, size_t len) {
+  const __m128i esc = _mm_set1_epi8('\033');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    unsigned stop = (unsigned)_mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, esc)));
+    if (stop)
+      return i + (size_t)__builtin_ctz(stop);
+  }
+  return i + plain_span_scalar(s + i, len - i);
+}
+
+// PCMPESTRM with the name as the set: bit j says whether set byte j occurs
+// in the 16 name bytes
+TARGET("sse4.2") static uint64_t charset_scan_sse42(const SimdCharset *cs, const char *s,
+                                                    size_t len) {
+  uint64_t found = 0;
+  for (size_t g = 0; g < cs->count; g += 16) {
+    int n = cs->count - g < 16 ? (int)(cs->count - g) : 16;
+    unsigned all = (1u << n) - 1;
+    __m128i set = _mm_loadu_si128((const __m128i *)(cs->bytes + g));
+    unsigned bits = 0;
+    for (size_t i = 0; i < len && bits != all; i += 16) {
+      int chunk = len - i < 16 ? (int)(len - i) : 16;
+      __m128i text;
+      if (chunk == 16) {
+        text = _mm_loadu_si128((const __m128i *)(s + i));
+      } else {
+        char tail[16] = {0};
+        memcpy(tail, s + i, (size_t)chunk);
+        text = _mm_loadu_si128((const __m128i *)tail);
+      }
+      __m128i hit = _mm_cmpestrm(text, chunk, set, n,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+      bits |= (unsigned)_mm_cvtsi128_si32(hit);
+    }
+    found |= (uint64_t)bits << g;
+  }
+  return found;
+}
+
+TARGET("sse4.2") static const char *find_sse42(const char *hay, size_t n, const char *needle,
+                                               size_t m) {
+  if (m < 2 || m > n)
+    return m == 1 ? memchr(hay, needle[0], n) : find_scalar(hay, n, needle, m);
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(hay + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(hay + i + m - 1));
+    unsigned mask = (unsigned)_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+    for (; mask; mask &= mask - 1) {
+      size_t at = i + (size_t)__builtin_ctz(mask);
+      if (memcmp(hay + at + 1, needle + 1, m - 2) == 0)
+        return hay + at;
+    }
+  }
+  return find_scalar(hay + i, n - i, needle, m);
+}
+
+// ============================================================================
+// AVX2
+// ============================================================================
+
+TARGET("avx2") static void lower_avx2(char *s, size_t len) {
+  const __m256i shift = _mm256_set1_epi8(LOWER_SHIFT);
+  const __m256i bound = _mm256_set1_epi8(LOWER_BOUND);
+  const __m256i flip = _mm256_set1_epi8('a' - 'A');
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+    __m256i upper = _mm256_cmpgt_epi8(bound, _mm256_add_epi8(v, shift));
+    _mm256_storeu_si256((__m256i *)(s + i), _mm256_add_epi8(v, _mm256_and_si256(upper, flip)));
+  }
+  lower_scalar(s + i, len - i);
+}
+
+TARGET("avx2") static size_t plain_span_avx2(const char *s, size_t len) {
+  const __m256i esc = _mm256_set1_epi8('\033');
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+    unsigned stop =
+        (unsigned)_mm256_movemask_epi8(_mm256_or_si256(v, _mm256_cmpeq_epi8(v, esc)));
+    if (stop)
+      return i + (size_t)__builtin_ctz(stop);
+  }
+  return i + plain_span_scalar(s + i, len - i);
+}
+
+TARGET("avx2") static uint64_t charset_scan_avx2(const SimdCharset *cs, const char *s,
+                                                 size_t len) {
+  uint64_t all = cs->count == 64 ? ~0ULL : (1ULL << cs->count) - 1;
+  uint64_t found = 0;
+  for (size_t i = 0; i < len && found != all; i += 32) {
+    __m256i text;
+    if (len - i >= 32) {
+      text = _mm256_loadu_si256((const __m256i *)(s + i));
+    } else {
+      // NUL padding never matches: sets hold no NULs
+      char tail[32] = {0};
+      memcpy(tail, s + i, len - i);
+      text = _mm256_loadu_si256((const __m256i *)tail);
+    }
+    for (size_t j = 0; j < cs->count; j++) {
+      __m256i eq = _mm256_cmpeq_epi8(text, _mm256_set1_epi8((char)cs->bytes[j]));
+      found |= (uint64_t)(_mm256_movemask_epi8(eq) != 0) << j;
+    }
+  }
+  return found;
+}
+
+TARGET("avx2") static const char *find_avx2(const char *hay, size_t n, const char *needle,
+                                            size_t m) {
+  if (m < 2 || m > n)
+    return m == 1 ? memchr(hay, needle[0], n) : find_scalar(hay, n, needle, m);
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 32 <= n; i += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(hay + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(hay + i + m - 1));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+    for (; mask; mask &= mask - 1) {
+      size_t at = i + (size_t)__builtin_ctz(mask);
+      if (memcmp(hay + at + 1, needle + 1, m - 2) == 0)
+        return hay + at;
+    }
+  }
+  return find_scalar(hay + i, n - i, needle, m);
+}
+
+// ============================================================================
+// AVX-512BW
+// ============================================================================
+//
+// Masked loads and stores cover the tails: masked-off bytes are never
+// touched, so nothing falls back to narrower code.
+
+static inline __mmask64 tail_mask(size_t left) {
+  return left >= 64 ? ~(__mmask64)0 : ((__mmask64)1 << left) - 1;
+}
+
+TARGET("avx512f,avx512bw") static void lower_avx512(char *s, size_t len) {
+  const __m512i shift = _mm512_set1_epi8(LOWER_SHIFT);
+  const __m512i bound = _mm512_set1_epi8(LOWER_BOUND);
+  const __m512i flip = _mm512_set1_epi8('a' - 'A');
+  for (size_t i = 0; i < len; i += 64) {
+    __mmask64 k = tail_mask(len - i);
+    __m512i v = _mm512_maskz_loadu_epi8(k, s + i);
+    __mmask64 upper = _mm512_cmplt_epi8_mask(_mm512_add_epi8(v, shift), bound);
+    _mm512_mask_storeu_epi8(s + i, k, _mm512_mask_add_epi8(v, upper, v, flip));
+  }
+}
+
+TARGET("avx512f,avx512bw") static size_t plain_span_avx512(const char *s, size_t len) {
+  const __m512i esc = _mm512_set1_epi8('\033');
+  for (size_t i = 0; i < len; i += 64) {
+    __mmask64 k = tail_mask(len - i);
+    __m512i v = _mm512_maskz_loadu_epi8(k, s + i);
+    uint64_t stop = (_mm512_movepi8_mask(v) | _mm512_cmpeq_epi8_mask(v, esc)) & k;
+    if (stop)
+      return i + (size_t)__builtin_ctzll(stop);
+  }
+  return len;
+}
+
+TARGET("avx512f,avx512bw") static uint64_t charset_scan_avx512(const SimdCharset *cs,
+                                                               const char *s, size_t len) {
+  uint64_t all = cs->count == 64 ? ~0ULL : (1ULL << cs->count) - 1;
+  uint64_t found = 0;
+  for (size_t i = 0; i < len && found != all; i += 64) {
+    __mmask64 k = tail_mask(len - i);
+    __m512i text = _mm512_maskz_loadu_epi8(k, s + i);
+    for (size_t j = 0; j < cs->count; j++) {
+      __mmask64 eq = _mm512_mask_cmpeq_epi8_mask(k, text, _mm512_set1_epi8((char)cs->bytes[j]));
+      found |= (uint64_t)(eq != 0) << j;
+    }
+  }
+  return found;
+}
+
+TARGET("avx512f,avx512bw") static const char *find_avx512(const char *hay, size_t n,
+                                                          const char *needle, size_t m) {
+  if (m < 2 || m > n)
+    return m == 1 ? memchr(hay, needle[0], n) : find_scalar(hay, n, needle, m);
+  const __m512i first = _mm512_set1_epi8(needle[0]);
+  const __m512i last = _mm512_set1_epi8(needle[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 64 <= n; i += 64) {
+    __m512i a = _mm512_loadu_si512((const void *)(hay + i));
+    __m512i b = _mm512_loadu_si512((const void *)(hay + i + m - 1));
+    uint64_t mask = _mm512_cmpeq_epi8_mask(a, first) & _mm512_cmpeq_epi8_mask(b, last);
+    for (; mask; mask &= mask - 1) {
+      size_t at = i + (size_t)__builtin_ctzll(mask);
+      if (memcmp(hay + at + 1, needle + 1, m - 2) == 0)
+        return hay + at;
+    }
+  }
+  return find_scalar(hay + i, n - i, needle, m);
+}
+
+#endif // SIMD_X86
+
+#ifdef SIMD_ARM
+
+// ============================================================================
+// NEON
+// ============================================================================
+
+// 4 bits per byte of a comparison result (NEON has no movemask)
+static inline uint64_t neon_mask(uint8x16_t eq) {
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+
+static void lower_neon(char *s, size_t len) {
+  const uint8x16_t a = vdupq_n_u8('A');
+  const uint8x16_t letters = vdupq_n_u8(26);
+  const uint8x16_t flip = vdupq_n_u8('a' - 'A');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t *)(s + i));
+    uint8x16_t upper = vcltq_u8(vsubq_u8(v, a), letters);
+    vst1q_u8((uint8_t *)(s + i), vaddq_u8(v, vandq_u8(upper, flip)));
+  }
+  lower_scalar(s + i, len - i);
+}
+
+static size_t plain_span_neon(const char *s, size_t len) {
+  const uint8x16_t high = vdupq_n_u8(0x80);
+  const uint8x16_t esc = vdupq_n_u8('\033');
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t *)(s + i));
+    uint64_t stop = neon_mask(vorrq_u8(vcgeq_u8(v, high), vceqq_u8(v, esc)));
+    if (stop)
+      return i + (size_t)(__builtin_ctzll(stop) >> 2);
+  }
+  return i + plain_span_scalar(s + i, len - i);
+}
+
+static uint64_t charset_scan_neon(const SimdCharset *cs, const char *s, size_t len) {
+  uint64_t all = cs->count == 64 ? ~0ULL : (1ULL << cs->count) - 1;
+  uint64_t found = 0;
+  for (size_t i = 0; i < len && found != all; i += 16) {
+    uint8x16_t text;
+    if (len - i >= 16) {
+      text = vld1q_u8((const uint8_t *)(s + i));
+    } else {
+      // NUL padding never matches: sets hold no NULs
+      uint8_t tail[16] = {0};
+      memcpy(tail, s + i, len - i);
+      text = vld1q_u8(tail);
+    }
+    for (size_t j = 0; j < cs->count; j++) {
+      uint8x16_t eq = vceqq_u8(text, vdupq_n_u8(cs->bytes[j]));
+      found |= (uint64_t)(vmaxvq_u8(eq) != 0) << j;
+    }
+  }
+  return found;
+}
+
+static const char *find_neon(const char *hay, size_t n, const char *needle, size_t m) {
+  if (m < 2 || m > n)
+    return m == 1 ? memchr(hay, needle[0], n) : find_scalar(hay, n, needle, m);
+  const uint8x16_t first = vdupq_n_u8((uint8_t)needle[0]);
+  const uint8x16_t last = vdupq_n_u8((uint8_t)needle[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16) {
+    uint8x16_t a = vld1q_u8((const uint8_t *)(hay + i));
+    uint8x16_t b = vld1q_u8((const uint8_t *)(hay + i + m - 1));
+    uint64_t mask = neon_mask(vandq_u8(vceqq_u8(a, first), vceqq_u8(b, last)));
+    for (; mask; mask &= ~(0xFULL << (__builtin_ctzll(mask) & ~3))) {
+      size_t at = i + (size_t)(__builtin_ctzll(mask) >> 2);
+      if (memcmp(hay + at + 1, needle + 1, m - 2) == 0)
+        return hay + at;
+    }
+  }
+  return find_scalar(hay + i, n - i, needle, m);
+}
+
+#endif // SIMD_ARM
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+static const char *const level_names[] = {
+    [SIMD_SCALAR] = "scalar",
+    [SIMD_SSE42] = "sse4.2",
+    [SIMD_AVX2] = "avx2",
+    [SIMD_AVX512] = "avx512",
+    [SIMD_NEON] = "neon",
+};
+
+const char *simd_level_name(SimdLevel level) {
+  return level_names[level];
+}
+
+static SimdLevel detect_level(void) {
+#if defined(SIMD_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw"))
+    return SIMD_AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return SIMD_AVX2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return SIMD_SSE42;
+#elif defined(SIMD_ARM)
+#if defined(__linux__) && defined(HWCAP_ASIMD)
+  if (!(getauxval(AT_HWCAP) & HWCAP_ASIMD))
+    return SIMD_SCALAR;
+#endif
+  return SIMD_NEON;
+#endif
+  return SIMD_SCALAR;
+}
+
+void simd_init(void) {
+  SimdLevel level = detect_level();
+
+  const char *env = getenv("TRY_SIMD");
+  for (int l = SIMD_SCALAR; env && l <= SIMD_NEON; l++) {
+    if (strcmp(env, level_names[l]) != 0)
+      continue;
+    // Another architecture's level leaves only the scalar kernels
+    if (l == SIMD_SCALAR || (l == SIMD_NEON) != (level == SIMD_NEON))
+      level = SIMD_SCALAR;
+    else if ((SimdLevel)l < level)
+      level = (SimdLevel)l;
+    break;
+  }
+
+  simd.level = level;
+  switch (level) {
+#if defined(SIMD_X86)
+  case SIMD_SSE42:
+    simd.lower = lower_sse42;
+    simd.plain_span = plain_span_sse42;
+    simd.charset_scan = charset_scan_sse42;
+    simd.find = find_sse42;
+    break;
+  case SIMD_AVX2:
+    simd.lower = lower_avx2;
+    simd.plain_span = plain_span_avx2;
+    simd.charset_scan = charset_scan_avx2;
+    simd.find = find_avx2;
+    break;
+  case SIMD_AVX512:
+    simd.lower = lower_avx512;
+    simd.plain_span = plain_span_avx512;
+    simd.charset_scan = charset_scan_avx512;
+    simd.find = find_avx512;
+    break;
+#elif defined(SIMD_ARM)
+  case SIMD_NEON:
+    simd.lower = lower_neon;
+    simd.plain_span = plain_span_neon;
+    simd.charset_scan = charset_scan_neon;
+    simd.find = find_neon;
+    break;
+#endif
+  default:
+    simd.level = SIMD_SCALAR;
+    simd.lower = lower_scalar;
+    simd.plain_span = plain_span_scalar;
+    simd.charset_scan = charset_scan_scalar;
+    simd.find = find_scalar;
+    break;
+  }
+}
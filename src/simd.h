@@ -0,0 +1,79 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Vector kernels with runtime dispatch
+// ============================================================================
+//
+// Release binaries are built with generic flags and run on whatever host
+// they land on, so every kernel is compiled once per instruction set (x86
+// levels through function target attributes; NEON is baseline on aarch64)
+// and simd_init() installs the best ones the CPU supports, found with cpuid
+// on x86 and getauxval() on Linux/aarch64. Until then, and on other
+// architectures, the scalar versions run.
+//
+// TRY_SIMD=scalar|sse4.2|avx2|avx512|neon forces a level for testing and
+// benchmarking. A level the CPU lacks falls back to the best one below it.
+
+typedef enum {
+  SIMD_SCALAR,
+  SIMD_SSE42,
+  SIMD_AVX2,
+  SIMD_AVX512,         // AVX-512BW
+  SIMD_NEON,
+} SimdLevel;
+
+// Up to 64 distinct (non-NUL) bytes to look for with simd_charset_scan()
+typedef struct {
+  uint64_t bit[256];        // Bit of each byte of the set, 0 for the others
+  unsigned char bytes[64];  // bytes[i] has bit i
+  size_t count;
+} SimdCharset;
+
+typedef struct {
+  SimdLevel level;
+  void (*lower)(char *s, size_t len);
+  size_t (*plain_span)(const char *s, size_t len);
+  uint64_t (*charset_scan)(const SimdCharset *cs, const char *s, size_t len);
+  const char *(*find)(const char *hay, size_t n, const char *needle, size_t m);
+} SimdKernels;
+
+extern SimdKernels simd;
+
+// Installs the kernels for this CPU (or TRY_SIMD). Call once at startup,
+// before any threads are started.
+void simd_init(void);
+
+const char *simd_level_name(SimdLevel level);
+
+// Fills the set with the distinct bytes of `bytes` (NULs and bytes past the
+// 64th distinct one are ignored)
+void simd_charset_init(SimdCharset *cs, const char *bytes, size_t len);
+
+// Lowercases ASCII letters in place (tolower() in the C locale)
+static inline void simd_lower(char *s, size_t len) {
+  simd.lower(s, len);
+}
+
+// Length of the leading run of bytes that take one terminal column each:
+// ASCII other than ESC
+static inline size_t simd_plain_span(const char *s, size_t len) {
+  return simd.plain_span(s, len);
+}
+
+// Bit i is set when cs->bytes[i] occurs in s
+static inline uint64_t simd_charset_scan(const SimdCharset *cs, const char *s, size_t len) {
+  return simd.charset_scan(cs, s, len);
+}
+
+// First occurrence of needle in hay (as memmem()), NULL if there's none
+static inline const char *simd_find(const char *hay, size_t n, const char *needle,
+                                    size_t m) {
+  return simd.find(hay, n, needle, m);
+}
+
+#endif // SIMD_H
@@ -0,0 +1,218 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "sizes.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIZES_MAGIC "TRYSIZE1"
+#define SIZES_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+} SizesHeader;
+
+typedef struct {
+  uint64_t inode;
+  int64_t mtime;
+  uint64_t bytes;
+  uint64_t files;
+} SizesRecord;
+
+// Reads all records of the cache file. Returns NULL if missing/invalid.
+static SizesRecord *read_records(const char *path, size_t *count) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+
+  struct stat sb;
+  SizesHeader hdr;
+  if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(hdr) ||
+      read(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr) ||
+      memcmp(hdr.magic, SIZES_MAGIC, 8) != 0 || hdr.version != SIZES_VERSION) {
+    close(fd);
+    return NULL;
+  }
+
+  size_t n = ((size_t)sb.st_size - sizeof(hdr)) / sizeof(SizesRecord);
+  SizesRecord *recs = malloc((n ? n : 1) * sizeof(SizesRecord));
+  if (recs && read(fd, recs, n * sizeof(SizesRecord)) !=
+                  (ssize_t)(n * sizeof(SizesRecord))) {
+    free(recs);
+    recs = NULL;
+  }
+  close(fd);
+  *count = n;
+  return recs;
+}
+
+void sizes_load(EntryStore *store) {
+  Z_CLEANUP(zstr_free) zstr path = join_path(zstr_cstr(&store->root), SIZES_FILE);
+  size_t count = 0;
+  SizesRecord *recs = read_records(zstr_cstr(&path), &count);
+  if (!recs)
+    return;
+
+  // Index records by inode (open addressing, load factor <= 0.5)
+  size_t cap = 16;
+  while (cap < count * 2)
+    cap *= 2;
+  int64_t *slots = malloc(cap * sizeof(int64_t));
+  if (!slots) {
+    free(recs);
+    return;
+  }
+  for (size_t i = 0; i < cap; i++)
+    slots[i] = -1;
+  for (size_t i = 0; i < count; i++) {
+    size_t h = (size_t)(recs[i].inode * 0x9e3779b97f4a7c15ULL) & (cap - 1);
+    while (slots[h] >= 0)
+      h = (h + 1) & (cap - 1);
+    slots[h] = (int64_t)i;
+  }
+
+  for (size_t i = 0; i < entry_count(store); i++) {
+    EntrySize *sz = entry_size(store, i);
+    size_t h = (size_t)(sz->inode * 0x9e3779b97f4a7c15ULL) & (cap - 1);
+    for (; slots[h] >= 0; h = (h + 1) & (cap - 1)) {
+      const SizesRecord *rec = &recs[slots[h]];
+      if (rec->inode == sz->inode && rec->mtime == (int64_t)sz->dir_mtime) {
+        sz->bytes = rec->bytes;
+        sz->files = rec->files;
+        sz->known = true;
+        break;
+      }
+    }
+  }
+
+  free(slots);
+  free(recs);
+}
+
+static int save_root(EntryStore *store, uint32_t root_id) {
+  Z_CLEANUP(zstr_free) zstr path =
+      join_path(zstr_cstr(&store->roots.data[root_id]), SIZES_FILE);
+
+  // Only current entries are written, so deleted directories drop out
+  size_t n = 0;
+  SizesRecord *recs = malloc((entry_count(store) + 1) * sizeof(SizesRecord));
+  if (!recs)
+    return -1;
+  for (size_t i = 0; i < entry_count(store); i++) {
+    const EntrySize *sz = entry_size(store, i);
+    if (sz->known && sz->inode != 0 && entry_root_id(store, i) == root_id) {
+      recs[n++] = (SizesRecord){.inode = sz->inode,
+                                .mtime = (int64_t)sz->dir_mtime,
+                                .bytes = sz->bytes,
+                                .files = sz->files};
+    }
+  }
+
+  SizesHeader hdr = {.version = SIZES_VERSION};
+  memcpy(hdr.magic, SIZES_MAGIC, 8);
+  int rc = write_file_atomic(zstr_cstr(&path), &hdr, sizeof(hdr), recs,
+                             n * sizeof(SizesRecord));
+  free(recs);
+  return rc;
+}
+
+int sizes_save(EntryStore *store) {
+  // Roots without entries (not scanned yet, or unreachable) keep their cache
+  bool *has_entries = calloc(store->roots.length, sizeof(bool));
+  if (!has_entries)
+    return -1;
+  for (size_t i = 0; i < entry_count(store); i++)
+    has_entries[entry_root_id(store, i)] = true;
+
+  int rc = 0;
+  for (uint32_t r = 0; r < store->roots.length; r++) {
+    if (has_entries[r] && save_root(store, r) != 0)
+      rc = -1;
+  }
+  free(has_entries);
+  return rc;
+}
+
+// ============================================================================
+// Background refresh
+// ============================================================================
+
+bool size_refresh_start(SizeRefresh *r, EntryStore *store) {
+  *r = (SizeRefresh){0};
+
+  // Entries may come from several roots: walk them by path (relative roots
+  // resolve against the working directory, like everywhere else)
+  vec_zstr paths = {0};
+  vec_char_ptr names = {0};
+  for (size_t i = 0; i < entry_count(store); i++) {
+    if (!entry_size(store, i)->known && !entry_nested(store, i)) {
+      vec_push_u32(&r->entries, (uint32_t)i);
+      vec_push_zstr(&paths, entry_path(store, i));
+    }
+  }
+  zstr *path;
+  vec_foreach(&paths, path) {
+    vec_push_char_ptr(&names, (char *)zstr_cstr(path));
+  }
+
+  if (names.length > 0) {
+    r->walk = du_start(".", (const char *const *)names.data, names.length);
+  }
+  vec_foreach(&paths, path) {
+    zstr_free(path);
+  }
+  vec_free_zstr(&paths);
+  vec_free_char_ptr(&names);
+  if (!r->walk)
+    vec_free_u32(&r->entries);
+  return r->walk != NULL;
+}
+
+bool size_refresh_poll(SizeRefresh *r, EntryStore *store) {
+  if (!r->walk)
+    return false;
+
+  // Sample completion first so no entry finishes unseen before the free
+  bool done = du_done(r->walk);
+  bool changed = false;
+  for (size_t w = 0; w < r->entries.length; w++) {
+    EntrySize *sz = entry_size(store, r->entries.data[w]);
+    if (sz->known)
+      continue;
+    DuUsage usage;
+    du_usage(r->walk, w, &usage);
+    if (usage.bytes != sz->bytes || usage.done) {
+      sz->bytes = usage.bytes;
+      sz->files = usage.files;
+      sz->known = usage.done;
+      r->dirty = r->dirty || usage.done;
+      changed = true;
+    }
+  }
+
+  if (done) {
+    du_free(r->walk);
+    r->walk = NULL;
+  }
+  return changed;
+}
+
+void size_refresh_finish(SizeRefresh *r, EntryStore *store) {
+  du_free(r->walk);
+  r->walk = NULL;
+  vec_free_u32(&r->entries);
+  if (r->dirty)
+    sizes_save(store);
+  r->dirty = false;
+}
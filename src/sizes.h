@@ -0,0 +1,53 @@
+#ifndef SIZES_H
+#define SIZES_H
+
+#include "du.h"
+#include "entries.h"
+#include <stdbool.h>
+
+// ============================================================================
+// Persisted size cache
+// ============================================================================
+//
+// Disk usage per try directory is kept in <tries>/.try_sizes:
+//
+//   header:  "TRYSIZE1" magic, uint32 version, uint32 reserved  (16 bytes)
+//   record:  uint64 inode, int64 directory mtime,
+//            uint64 bytes, uint64 files                         (32 bytes)
+//
+// A record is reused while the directory's inode and mtime are unchanged, so
+// repeated launches only walk new or modified trees. The mtime of a
+// directory changes when entries are added, removed or renamed directly in
+// it; edits deeper in the tree are picked up once the top level changes.
+
+#define SIZES_FILE ".try_sizes"
+
+// Marks entries whose cached record still matches as known (single-root
+// store, see entry_store_merge())
+void sizes_load(EntryStore *store);
+
+// Rewrites the cache of each root with the known sizes of its entries
+int sizes_save(EntryStore *store);
+
+// Background refresh of entries without a current size
+typedef struct {
+  DuWalk *walk;
+  vec_u32 entries;     // Store index for each walked name
+  bool dirty;          // New sizes to persist
+} SizeRefresh;
+
+// Starts walking every entry whose size isn't known. Returns false if
+// there is nothing to do.
+bool size_refresh_start(SizeRefresh *r, EntryStore *store);
+
+// Copies progress into the store. Returns true if any size changed.
+bool size_refresh_poll(SizeRefresh *r, EntryStore *store);
+
+static inline bool size_refresh_active(const SizeRefresh *r) {
+  return r->walk != NULL;
+}
+
+// Stops the walk (unfinished entries stay unknown) and saves new sizes
+void size_refresh_finish(SizeRefresh *r, EntryStore *store);
+
+#endif // SIZES_H
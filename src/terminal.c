@@ -31,6 +31,7 @@
 
 #include "terminal.h"
 #include <errno.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -298,6 +299,23 @@ int read_key(void) {
   }
 }
 
+int read_key_timeout(int timeout_ms) {
+  // Wait for input without blocking past the deadline, so callers can keep
+  // redrawing while background work makes progress
+  struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+  int ready = poll(&pfd, 1, timeout_ms);
+  if (ready == 0)
+    return KEY_TIMEOUT;
+  if (ready < 0) {
+    if (errno == EINTR) {
+      window_size_valid = 0; // Invalidate cache on resize
+      return KEY_RESIZE;
+    }
+    return -1;
+  }
+  return read_key();
+}
+
 int get_window_size(int *rows, int *cols) {
   // Return cached values if valid
   if (window_size_valid) {
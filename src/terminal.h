@@ -18,7 +18,8 @@ enum EditorKey {
   KEY_UNKNOWN,  // Unrecognized escape sequence - should be ignored
   ENTER_KEY = 13,
   ESC_KEY = 27,
-  KEY_RESIZE = -2
+  KEY_RESIZE = -2,
+  KEY_TIMEOUT = -3  // read_key_timeout(): no input within the timeout
 };
 
 void enable_raw_mode(void);
@@ -26,6 +27,7 @@ void disable_raw_mode(void);
 void tui_drain_input(void);  // Consume remaining stdin after TUI exit
 int get_window_size(int *rows, int *cols);
 int read_key(void);
+int read_key_timeout(int timeout_ms);  // Like read_key(), KEY_TIMEOUT if idle
 void enable_alternate_screen(void);
 void disable_alternate_screen(void);
 void clear_screen(void);
@@ -0,0 +1,163 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "trash.h"
+#include "rmtree.h"
+#include "utils.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+extern char **environ;
+
+bool trash_mode_enabled(void) {
+  const char *mode = getenv("TRY_DELETE_MODE");
+  return mode && strcmp(mode, "trash") == 0;
+}
+
+// Opens <root>/.trash, creating it if needed. Refuses symlinks.
+static int open_trash(int rootfd, bool create) {
+  if (create && mkdirat(rootfd, TRASH_DIR, 0700) != 0 && errno != EEXIST)
+    return -1;
+  return openat(rootfd, TRASH_DIR,
+                O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+}
+
+size_t trash_move(const char *tries_path, const char *const *names, size_t count) {
+  int rootfd = open(tries_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (rootfd < 0)
+    return 0;
+  int trashfd = open_trash(rootfd, true);
+  if (trashfd < 0) {
+    close(rootfd);
+    return 0;
+  }
+
+  size_t moved = 0;
+  for (size_t i = 0; i < count; i++) {
+    const char *name = names[i];
+    if (!*name || strchr(name, '/') || strcmp(name, ".") == 0 ||
+        strcmp(name, "..") == 0)
+      continue;
+
+    // Unique within the trash: a same-named directory may already be there
+    char target[256];
+    snprintf(target, sizeof(target), "%.200s.%ld.%d.%zu", name,
+             (long)time(NULL), (int)getpid(), i);
+    if (renameat(rootfd, name, trashfd, target) == 0)
+      moved++;
+  }
+
+  close(trashfd);
+  close(rootfd);
+  return moved;
+}
+
+// Lowest CPU and I/O priority so purging never competes with the user
+static void lower_priority(void) {
+  setpriority(PRIO_PROCESS, 0, 19); // Best effort
+#if defined(__linux__) && defined(SYS_ioprio_set)
+  // ioprio_set(IOPRIO_WHO_PROCESS, self, IOPRIO_CLASS_IDLE)
+  syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+}
+
+static void purge(const char *tries_path) {
+  int rootfd = open(tries_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (rootfd < 0)
+    return;
+  int trashfd = open_trash(rootfd, false);
+  close(rootfd);
+  if (trashfd < 0)
+    return;
+
+  // Everything in the trash, including leftovers of interrupted purges
+  vec_zstr names = {0};
+  int scan_fd = dup(trashfd);
+  DIR *d = scan_fd >= 0 ? fdopendir(scan_fd) : NULL;
+  if (d) {
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+      if (strcmp(de->d_name, ".") != 0 && strcmp(de->d_name, "..") != 0)
+        vec_push_zstr(&names, zstr_from(de->d_name));
+    }
+    closedir(d);
+  } else if (scan_fd >= 0) {
+    close(scan_fd);
+  }
+
+  if (names.length > 0) {
+    const char **list = malloc(names.length * sizeof(char *));
+    if (list) {
+      for (size_t i = 0; i < names.length; i++)
+        list[i] = zstr_cstr(&names.data[i]);
+      rmtree_remove(trashfd, list, names.length);
+      free(list);
+    }
+  }
+
+  zstr *iter;
+  vec_foreach(&names, iter) {
+    zstr_free(iter);
+  }
+  vec_free_zstr(&names);
+  close(trashfd);
+}
+
+// The selector has worker threads running (git status, previews, root
+// scans), so it can't just fork and keep going in the child. The purger is a
+// fresh exec of this binary instead, with its stdio on /dev/null.
+void trash_purge_async(const char *tries_path) {
+  char self[1024];
+  if (!self_exe_path(self, sizeof(self)))
+    return;
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+  char *argv[] = {self, TRASH_PURGE_FLAG, (char *)tries_path, NULL};
+  pid_t pid;
+  int err = posix_spawn(&pid, self, &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (err != 0)
+    return;
+
+  // Reap the intermediate process; the purger is reparented to init
+  while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {
+  }
+}
+
+int trash_purge_main(const char *tries_path) {
+  // Single-threaded here, so forking is safe: a new session so the purger
+  // survives the terminal, and a second process so the selector only waits
+  // for this one
+  setsid();
+  pid_t pid = fork();
+  if (pid < 0)
+    return 1;
+  if (pid > 0)
+    return 0;
+
+  lower_priority();
+  purge(tries_path);
+  return 0;
+}
@@ -0,0 +1,34 @@
+#ifndef TRASH_H
+#define TRASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// Trash-then-purge delete mode (TRY_DELETE_MODE=trash)
+// ============================================================================
+//
+// Deleting moves each directory into <tries>/.trash with a single renameat,
+// which is instant regardless of size. The actual removal runs afterwards in
+// a detached, low-priority (nice 19, idle I/O class) background process.
+// scan_tries() skips dot-directories, so trashed entries vanish from the list
+// at once, and a purge interrupted by shutdown is finished by the next one.
+
+#define TRASH_DIR ".trash"
+#define TRASH_PURGE_FLAG "--purge-trash"  // argv[1] of the background purger
+
+// True if TRY_DELETE_MODE=trash
+bool trash_mode_enabled(void);
+
+// Moves the named entries of tries_path into the trash. Returns the number
+// moved; entries that could not be moved are left in place.
+size_t trash_move(const char *tries_path, const char *const *names, size_t count);
+
+// Starts a detached background process (this binary run with
+// TRASH_PURGE_FLAG) that empties the trash
+void trash_purge_async(const char *tries_path);
+
+// main() of the background purger
+int trash_purge_main(const char *tries_path);
+
+#endif // TRASH_H
@@ -0,0 +1,440 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "treeindex.h"
+#include "pool.h"
+#include "utils.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INDEX_MAGIC "TRYINDX1"
+#define INDEX_VERSION 1
+#define NOT_LISTED (-1)
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t depth;
+} IndexHeader;
+
+typedef struct {
+  int64_t mtime;
+  uint32_t path_len;
+  uint32_t reserved;
+} IndexRecord;
+
+// Directory names never descended into (besides dot-directories)
+static const char *const skip_names[] = {
+    "node_modules", "target", "vendor", "build", "dist",
+    "__pycache__",  "venv",   "Pods",   "DerivedData",
+};
+
+// A directory of the previous index
+typedef struct {
+  int64_t mtime;
+  const char *path;    // Into OldIndex.buf
+  int32_t first_child;
+  int32_t next_sibling;
+} OldDir;
+
+typedef struct {
+  char *buf;           // NUL-terminated paths of all records
+  OldDir *dirs;
+  size_t count;
+  int32_t *slots;      // Path hash -> dirs index, -1 = empty
+  size_t cap;
+} OldIndex;
+
+typedef struct {
+  zstr path;
+  int64_t mtime;
+} NewDir;
+
+Z_VEC_GENERATE_IMPL(NewDir, NewDir)
+
+typedef struct {
+  Pool *pool;
+  int rootfd;
+  int depth;
+  const OldIndex *old;
+  atomic_bool relisted;     // Some directory was read from disk
+  pthread_mutex_t lock;
+  vec_NewDir out;           // Guarded by lock
+} TreeWalk;
+
+typedef struct {
+  TreeWalk *walk;
+  int32_t old_dir;     // Record in the old index, -1 if new
+  int level;           // 0 = the try itself
+  char path[];
+} WalkTask;
+
+int tree_index_depth(void) {
+  const char *env = getenv("TRY_DEPTH");
+  int depth = env ? atoi(env) : 0;
+  if (depth <= 0)
+    return 0;
+  return depth > TREE_INDEX_MAX_DEPTH ? TREE_INDEX_MAX_DEPTH : depth;
+}
+
+static bool skipped(const char *name) {
+  if (name[0] == '.')
+    return true;
+  for (size_t i = 0; i < sizeof(skip_names) / sizeof(skip_names[0]); i++) {
+    if (strcmp(name, skip_names[i]) == 0)
+      return true;
+  }
+  return false;
+}
+
+// ============================================================================
+// Persisted index
+// ============================================================================
+
+static uint64_t hash_path(const char *s, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ULL;  // FNV-1a
+  for (size_t i = 0; i < len; i++)
+    h = (h ^ (unsigned char)s[i]) * 0x100000001b3ULL;
+  return h;
+}
+
+static int32_t old_lookup(const OldIndex *old, const char *path, size_t len) {
+  if (old->cap == 0)
+    return -1;
+  size_t i = (size_t)hash_path(path, len) & (old->cap - 1);
+  for (; old->slots[i] >= 0; i = (i + 1) & (old->cap - 1)) {
+    const char *p = old->dirs[old->slots[i]].path;
+    if (strncmp(p, path, len) == 0 && p[len] == '\0')
+      return old->slots[i];
+  }
+  return -1;
+}
+
+static void old_free(OldIndex *old) {
+  free(old->buf);
+  free(old->dirs);
+  free(old->slots);
+  *old = (OldIndex){0};
+}
+
+static void old_load(OldIndex *old, const char *path, int depth) {
+  *old = (OldIndex){0};
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+  struct stat sb;
+  if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(IndexHeader)) {
+    close(fd);
+    return;
+  }
+  size_t len = (size_t)sb.st_size;
+  char *file = malloc(len);
+  bool ok = file && read(fd, file, len) == (ssize_t)len;
+  close(fd);
+
+  IndexHeader hdr;
+  if (ok)
+    memcpy(&hdr, file, sizeof(hdr));
+  if (!ok || memcmp(hdr.magic, INDEX_MAGIC, 8) != 0 ||
+      hdr.version != INDEX_VERSION || hdr.depth != (uint32_t)depth) {
+    free(file);
+    return;
+  }
+
+  // Paths are copied out NUL-terminated; every record has a 16-byte
+  // header, so the copies always fit in the file's size
+  size_t max_dirs = (len - sizeof(IndexHeader)) / sizeof(IndexRecord);
+  old->buf = malloc(len);
+  old->dirs = malloc((max_dirs ? max_dirs : 1) * sizeof(OldDir));
+  if (!old->buf || !old->dirs) {
+    free(file);
+    old_free(old);
+    return;
+  }
+  size_t off = sizeof(IndexHeader), used = 0;
+  while (off + sizeof(IndexRecord) <= len) {
+    IndexRecord rec;
+    memcpy(&rec, file + off, sizeof(rec));
+    off += sizeof(rec);
+    if (rec.path_len == 0 || rec.path_len > len - off)
+      break;
+    char *p = old->buf + used;
+    memcpy(p, file + off, rec.path_len);
+    p[rec.path_len] = '\0';
+    used += rec.path_len + 1;
+    off += rec.path_len;
+    old->dirs[old->count++] = (OldDir){.mtime = rec.mtime,
+                                       .path = p,
+                                       .first_child = -1,
+                                       .next_sibling = -1};
+  }
+  free(file);
+  // A partial index would hide the children of complete records
+  if (off != len) {
+    old_free(old);
+    return;
+  }
+
+  old->cap = 16;
+  while (old->cap < old->count * 2)
+    old->cap *= 2;
+  old->slots = malloc(old->cap * sizeof(int32_t));
+  if (!old->slots) {
+    old_free(old);
+    return;
+  }
+  for (size_t i = 0; i < old->cap; i++)
+    old->slots[i] = -1;
+  for (size_t i = 0; i < old->count; i++) {
+    const char *p = old->dirs[i].path;
+    size_t h = (size_t)hash_path(p, strlen(p)) & (old->cap - 1);
+    while (old->slots[h] >= 0)
+      h = (h + 1) & (old->cap - 1);
+    old->slots[h] = (int32_t)i;
+  }
+
+  // Link every directory to its parent's child list
+  for (size_t i = 0; i < old->count; i++) {
+    const char *p = old->dirs[i].path;
+    const char *slash = strrchr(p, '/');
+    if (!slash)
+      continue;
+    int32_t parent = old_lookup(old, p, (size_t)(slash - p));
+    if (parent < 0)
+      continue;
+    old->dirs[i].next_sibling = old->dirs[parent].first_child;
+    old->dirs[parent].first_child = (int32_t)i;
+  }
+}
+
+static int compare_new_dirs(const void *a, const void *b) {
+  return strcmp(zstr_cstr(&((const NewDir *)a)->path),
+                zstr_cstr(&((const NewDir *)b)->path));
+}
+
+static void index_save(const char *path, const vec_NewDir *dirs, int depth) {
+  zstr buf = zstr_init();
+  IndexHeader hdr = {.version = INDEX_VERSION, .depth = (uint32_t)depth};
+  memcpy(hdr.magic, INDEX_MAGIC, 8);
+  zstr_cat_len(&buf, (const char *)&hdr, sizeof(hdr));
+  for (size_t i = 0; i < dirs->length; i++) {
+    const zstr *p = &dirs->data[i].path;
+    IndexRecord rec = {.mtime = dirs->data[i].mtime,
+                       .path_len = (uint32_t)zstr_len(p)};
+    zstr_cat_len(&buf, (const char *)&rec, sizeof(rec));
+    zstr_cat_len(&buf, zstr_cstr(p), zstr_len(p));
+  }
+
+  write_file_atomic(path, zstr_cstr(&buf), zstr_len(&buf), NULL, 0);
+  zstr_free(&buf);
+}
+
+// ============================================================================
+// Walker
+// ============================================================================
+
+static void record_dir(TreeWalk *walk, const char *path, size_t len, int64_t mtime) {
+  NewDir dir = {.path = zstr_from_len(path, len), .mtime = mtime};
+  pthread_mutex_lock(&walk->lock);
+  vec_push_NewDir(&walk->out, dir);
+  pthread_mutex_unlock(&walk->lock);
+}
+
+static void walk_task(void *arg);
+
+// Records a child of a listed directory and walks it if within depth
+static void visit_child(TreeWalk *walk, const WalkTask *parent, const char *name,
+                        int32_t old_dir) {
+  size_t plen = strlen(parent->path);
+  size_t nlen = strlen(name);
+  if (parent->level + 1 >= walk->depth) {
+    // At the depth limit: listed as an entry, never read
+    char *path = malloc(plen + 1 + nlen);
+    if (!path)
+      return;
+    memcpy(path, parent->path, plen);
+    path[plen] = '/';
+    memcpy(path + plen + 1, name, nlen);
+    record_dir(walk, path, plen + 1 + nlen, NOT_LISTED);
+    free(path);
+    return;
+  }
+
+  WalkTask *task = malloc(sizeof(WalkTask) + plen + 1 + nlen + 1);
+  if (!task)
+    return;
+  task->walk = walk;
+  task->level = parent->level + 1;
+  memcpy(task->path, parent->path, plen);
+  task->path[plen] = '/';
+  memcpy(task->path + plen + 1, name, nlen + 1);
+  task->old_dir = old_dir >= 0 ? old_dir
+                               : old_lookup(walk->old, task->path, plen + 1 + nlen);
+  pool_submit(walk->pool, walk_task, task);
+}
+
+static void walk_task(void *arg) {
+  WalkTask *task = arg;
+  TreeWalk *walk = task->walk;
+  const OldIndex *old = walk->old;
+
+  // Tries themselves may be symlinks (like the top-level scan), nested
+  // directories are never followed
+  struct stat sb;
+  int flags = task->level == 0 ? 0 : AT_SYMLINK_NOFOLLOW;
+  if (fstatat(walk->rootfd, task->path, &sb, flags) != 0 || !S_ISDIR(sb.st_mode)) {
+    free(task);
+    return;
+  }
+  int64_t mtime = (int64_t)sb.st_mtime * 1000000000LL + (int64_t)STAT_MTIME_NSEC(sb);
+  record_dir(walk, task->path, strlen(task->path), mtime);
+
+  // Unchanged since it was indexed: children come from the old index
+  if (task->old_dir >= 0 && old->dirs[task->old_dir].mtime == mtime) {
+    for (int32_t c = old->dirs[task->old_dir].first_child; c >= 0;
+         c = old->dirs[c].next_sibling) {
+      visit_child(walk, task, strrchr(old->dirs[c].path, '/') + 1, c);
+    }
+    free(task);
+    return;
+  }
+
+  atomic_store(&walk->relisted, true);
+  int fd = openat(walk->rootfd, task->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  DIR *d = fd >= 0 ? fdopendir(fd) : NULL;
+  if (!d) {
+    if (fd >= 0)
+      close(fd);
+    free(task);
+    return;
+  }
+  struct dirent *de;
+  while ((de = readdir(d)) != NULL) {
+    if (skipped(de->d_name))
+      continue;
+    bool is_dir = de->d_type == DT_DIR;
+    if (de->d_type == DT_UNKNOWN) {
+      struct stat csb;
+      is_dir = fstatat(dirfd(d), de->d_name, &csb, AT_SYMLINK_NOFOLLOW) == 0 &&
+               S_ISDIR(csb.st_mode);
+    }
+    if (is_dir)
+      visit_child(walk, task, de->d_name, -1);
+  }
+  closedir(d);
+  free(task);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// qsort() context; roots are indexed on concurrent threads (see rootscan.h)
+static _Thread_local EntryStore *sort_store;
+
+static int compare_top_names(const void *a, const void *b) {
+  return strcmp(entry_name(sort_store, *(const uint32_t *)a),
+                entry_name(sort_store, *(const uint32_t *)b));
+}
+
+// Store index of the try a nested path belongs to, or -1
+static int64_t find_try(EntryStore *store, const vec_u32 *tops, const char *path) {
+  size_t len = strcspn(path, "/");
+  size_t lo = 0, hi = tops->length;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const char *name = entry_name(store, tops->data[mid]);
+    int cmp = strncmp(name, path, len);
+    if (cmp == 0 && name[len] != '\0')
+      cmp = 1;
+    if (cmp == 0)
+      return tops->data[mid];
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return -1;
+}
+
+void tree_index_scan(EntryStore *store, int depth) {
+  if (depth <= 0 || entry_count(store) == 0)
+    return;
+
+  const char *root = zstr_cstr(&store->root);
+  Z_CLEANUP(zstr_free) zstr index_path = join_path(root, TREE_INDEX_FILE);
+  OldIndex old;
+  old_load(&old, zstr_cstr(&index_path), depth);
+
+  TreeWalk walk = {.depth = depth, .old = &old};
+  walk.rootfd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  walk.pool = walk.rootfd >= 0 ? pool_create(pool_default_threads()) : NULL;
+  if (!walk.pool) {
+    if (walk.rootfd >= 0)
+      close(walk.rootfd);
+    old_free(&old);
+    return;
+  }
+  atomic_init(&walk.relisted, false);
+  pthread_mutex_init(&walk.lock, NULL);
+
+  size_t tries = entry_count(store);
+  for (size_t i = 0; i < tries; i++) {
+    const char *name = entry_name(store, i);
+    size_t len = entry_name_len(store, i);
+    WalkTask *task = malloc(sizeof(WalkTask) + len + 1);
+    if (!task)
+      continue;
+    task->walk = &walk;
+    task->level = 0;
+    memcpy(task->path, name, len + 1);
+    task->old_dir = old_lookup(&old, name, len);
+    pool_submit(walk.pool, walk_task, task);
+  }
+  pool_destroy(walk.pool);
+  close(walk.rootfd);
+  pthread_mutex_destroy(&walk.lock);
+
+  // Stable order regardless of which worker finished first
+  if (walk.out.length > 1)
+    qsort(walk.out.data, walk.out.length, sizeof(NewDir), compare_new_dirs);
+
+  // Tries added or removed change the record set even if nothing was listed
+  if (atomic_load(&walk.relisted) || walk.out.length != old.count)
+    index_save(zstr_cstr(&index_path), &walk.out, depth);
+  old_free(&old);
+
+  vec_u32 tops = {0};
+  for (size_t i = 0; i < tries; i++)
+    vec_push_u32(&tops, (uint32_t)i);
+  sort_store = store;
+  qsort(tops.data, tops.length, sizeof(uint32_t), compare_top_names);
+  sort_store = NULL;
+
+  NewDir *dir;
+  vec_foreach(&walk.out, dir) {
+    const char *path = zstr_cstr(&dir->path);
+    if (strchr(path, '/')) {
+      int64_t top = find_try(store, &tops, path);
+      if (top >= 0) {
+        size_t i = entry_store_push(store, zstr_as_view(&dir->path), entry_mtime(store, (size_t)top));
+        store->nested.data[i] = true;
+        store->frecency.data[i] = store->frecency.data[top];
+      }
+    }
+    zstr_free(&dir->path);
+  }
+  vec_free_NewDir(&walk.out);
+  vec_free_u32(&tops);
+}
@@ -0,0 +1,38 @@
+#ifndef TREEINDEX_H
+#define TREEINDEX_H
+
+#include "entries.h"
+
+// ============================================================================
+// Nested directory index
+// ============================================================================
+//
+// Opt-in (TRY_DEPTH=N): subdirectories up to N levels inside each try are
+// added to the entry store as "<try>/<sub>/...", so fuzzy search can find a
+// subproject. Dot-directories and build/dependency trees (node_modules,
+// target, vendor, ...) are skipped and symlinks are not followed.
+//
+// The walk runs on the work-stealing pool and is persisted in
+// <tries>/.try_index:
+//
+//   header:  "TRYINDX1" magic, uint32 version, uint32 depth      (16 bytes)
+//   record:  int64 mtime (ns, -1 = not listed), uint32 path length,
+//            uint32 reserved, path bytes                    (16 + n bytes)
+//
+// A directory's record lists it and, implicitly, its children (the records
+// one level below it). On the next launch each listed directory is only
+// stat'ed: its children are re-read only if its mtime changed, which is
+// exactly when entries were added, removed or renamed in it.
+
+#define TREE_INDEX_FILE ".try_index"
+#define TREE_INDEX_MAX_DEPTH 6
+
+// Levels to index below each try: TRY_DEPTH clamped to 1..6, 0 when unset
+int tree_index_depth(void);
+
+// Appends the nested directories of the store's tries (flagged with
+// entry_nested()), refreshing and saving the persisted index. Nested
+// entries inherit the recency of their try.
+void tree_index_scan(EntryStore *store, int depth);
+
+#endif // TREEINDEX_H
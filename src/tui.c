@@ -6,12 +6,26 @@
 #endif
 
 #include "tui.h"
+#include "archive.h"
+#include "du.h"
+#include "entries.h"
 #include "fuzzy.h"
+#include "postings.h"
+#include "gitstatus.h"
+#include "history.h"
+#include "preview.h"
+#include "rmtree.h"
+#include "rootscan.h"
+#include "sizes.h"
 #include "terminal.h"
+#include "trash.h"
+#include "treeindex.h"
 #include "utils.h"
 #include "zvec.h"
 #include <ctype.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,18 +37,23 @@
 // Helper macro to ignore write return values
 #define WRITE(fd, buf, len) do { ssize_t unused = write(fd, buf, len); (void)unused; } while(0)
 
-// Generate vector implementation for TryEntry
-Z_VEC_GENERATE_IMPL(TryEntry, TryEntry)
-
-// Generate vector implementation for TryEntry pointers
-Z_VEC_GENERATE_IMPL(TryEntry *, TryEntryPtr)
-
-static vec_TryEntry all_tries = {0};
-static vec_TryEntryPtr filtered_ptrs = {0};
+static EntryStore all_tries = {0};
+static vec_u32 filtered = {0};  // Indices into all_tries, sorted by score
+static vec_u32 candidates = {0};  // Entries the postings index lets through
+static bool highlight_matches = false;  // Filter has terms: paint match positions
 static TuiInput filter_input = {0};
 static int selected_index = 0;
 static int scroll_offset = 0;
 static int marked_count = 0;  // Number of items marked for deletion
+static bool size_mode = false;  // Ctrl-S: size column, largest first
+static SizeRefresh size_refresh = {0};
+static GitStatus *git_status = NULL;  // Branch/dirty badges of visible rows
+static bool git_status_sync = false;  // Test mode: wait for badges
+static vec_u32 visible_rows = {0};
+static bool preview_mode = false;  // Ctrl-O: preview pane of the selection
+static PreviewLoader *preview_loader = NULL;
+static RootScan *root_scan = NULL;  // Roots whose scan is still running
+static vec_zstr root_labels = {0};  // Root indicator for each root id
 
 // Memoized separator line
 static zstr cached_sep_line = {0};
@@ -63,91 +82,186 @@ static void handle_winch(int sig) {
   (void)sig;
 }
 
-static void free_entry(TryEntry *entry) {
-  zstr_free(&entry->path);
-  zstr_free(&entry->name);
-  zstr_free(&entry->rendered);
+static void free_root_state(void) {
+  root_scan_free(root_scan);
+  root_scan = NULL;
+  zstr *label;
+  vec_foreach(&root_labels, label) {
+    zstr_free(label);
+  }
+  vec_free_zstr(&root_labels);
 }
 
 static void clear_state(void) {
-  // Free contents of all_tries
-  for (size_t i = 0; i < all_tries.length; i++) {
-    free_entry(&all_tries.data[i]);
-  }
-  vec_free_TryEntry(&all_tries);
+  entry_store_free(&all_tries);
+  vec_free_u32(&filtered);
+  vec_free_u32(&candidates);
+}
 
-  // filtered_ptrs just contains pointers, no need to free entries
-  vec_free_TryEntryPtr(&filtered_ptrs);
+// Best score first, reading only the packed score column. Ties keep scan
+// order so equal entries don't trade places between passes.
+static inline bool ranks_by_score(uint32_t a, uint32_t b) {
+  float sa = all_tries.score.data[a];
+  float sb = all_tries.score.data[b];
+  return sa > sb || (sa == sb && a < b);
 }
 
-static int compare_tries_by_score(const void *a, const void *b) {
-  const TryEntry *const *ta = (const TryEntry *const *)a;
-  const TryEntry *const *tb = (const TryEntry *const *)b;
-  if ((*ta)->score > (*tb)->score)
-    return -1;
-  if ((*ta)->score < (*tb)->score)
-    return 1;
-  return 0;
+Z_SORT_GENERATE_IMPL(uint32_t, by_score, ranks_by_score)
+
+// Scans all roots concurrently. Returns once the first one is listed (or
+// every one with wait_all set); the others are merged by the main loop.
+static void scan_tries(const vec_zstr *roots, bool wait_all) {
+  entry_store_free(&all_tries);
+  entry_store_init(&all_tries, zstr_cstr(&roots->data[0]), time(NULL));
+  for (size_t i = 1; i < roots->length; i++) {
+    entry_store_add_root(&all_tries, zstr_cstr(&roots->data[i]));
+  }
+  root_scan = root_scan_start(&all_tries, tree_index_depth());
+  root_scan_wait(root_scan, wait_all);
+  root_scan_poll(root_scan, &all_tries);
 }
 
-static void scan_tries(const char *base_path) {
-  // Clear existing
-  for (size_t i = 0; i < all_tries.length; i++) {
-    free_entry(&all_tries.data[i]);
+// Last `parts` components of a path, trailing slashes ignored
+static zstr path_tail(const zstr *path, int parts) {
+  const char *s = zstr_cstr(path);
+  size_t end = zstr_len(path);
+  while (end > 1 && s[end - 1] == '/') end--;
+  size_t start = end;
+  while (parts-- > 0) {
+    while (start > 0 && s[start - 1] != '/') start--;
+    if (parts > 0 && start > 0) start--;  // Step over the separator
   }
-  vec_clear_TryEntry(&all_tries);
+  return start < end ? zstr_from_len(s + start, end - start) : zstr_dup(path);
+}
 
-  DIR *d = opendir(base_path);
-  if (!d)
-    return;
+// Label of a root in the list: its directory name, or the last two
+// components when another root has the same name
+static zstr root_label(const vec_zstr *roots, size_t index) {
+  zstr label = path_tail(&roots->data[index], 1);
+  for (size_t j = 0; j < roots->length; j++) {
+    if (j == index) continue;
+    Z_CLEANUP(zstr_free) zstr other = path_tail(&roots->data[j], 1);
+    if (strcmp(zstr_cstr(&other), zstr_cstr(&label)) == 0) {
+      zstr_free(&label);
+      return path_tail(&roots->data[index], 2);
+    }
+  }
+  return label;
+}
 
-  struct dirent *dir;
-  while ((dir = readdir(d)) != NULL) {
-    if (dir->d_name[0] == '.')
-      continue;
+// Rename and delete scripts work on directories in the primary root
+static bool can_modify(size_t entry) {
+  return !entry_nested(&all_tries, entry) && !entry_archived(&all_tries, entry) &&
+         entry_root_id(&all_tries, entry) == 0;
+}
 
-    zstr full_path = join_path(base_path, dir->d_name);
+// Size mode: largest first, score breaks ties
+static inline bool ranks_by_size(uint32_t a, uint32_t b) {
+  uint64_t sa = entry_size(&all_tries, a)->bytes;
+  uint64_t sb = entry_size(&all_tries, b)->bytes;
+  if (sa != sb)
+    return sa > sb;
+  return ranks_by_score(a, b);
+}
 
-    struct stat sb;
-    if (stat(zstr_cstr(&full_path), &sb) == 0 && S_ISDIR(sb.st_mode)) {
-      TryEntry entry = {0};
-      entry.path = full_path; // Move ownership
-      entry.name = zstr_from(dir->d_name);
-      entry.mtime = sb.st_mtime;
-      // Initial render = name (no highlighting)
-      entry.rendered = zstr_dup(&entry.name);
-      entry.score = 0; // Will be calculated in filter
+Z_SORT_GENERATE_IMPL(uint32_t, by_size, ranks_by_size)
 
-      vec_push_TryEntry(&all_tries, entry);
-    } else {
-      zstr_free(&full_path);
-    }
-  }
-  closedir(d);
+static void rank_tries(uint32_t *ids, size_t n) {
+  if (size_mode)
+    zsort_by_size(ids, n);
+  else
+    zsort_by_score(ids, n);
 }
 
 static void filter_tries(void) {
-  vec_clear_TryEntryPtr(&filtered_ptrs);
-  const char *query = zstr_cstr(&filter_input.text);
-
-  TryEntry *iter;
-  vec_foreach(&all_tries, iter) {
-    TryEntry *entry = iter;
-
-    // Update score and rendered string
-    fuzzy_match(entry, query);
+  vec_clear_u32(&filtered);
+
+  // Parse (and lowercase) the query once per pass, not once per entry
+  Z_CLEANUP(fuzzy_query_free) FuzzyQuery query;
+  fuzzy_query_parse(&query, zstr_cstr(&filter_input.text), all_tries.now);
+  zstr_view plain = fuzzy_query_plain(&query);
+  bool searching = query.count > 0;
+  highlight_matches = searching;
+
+  // Date filters: only entries in the date range can match. Otherwise, on
+  // large stores, only entries holding every character of the positive
+  // terms can.
+  bool indexed = query.dated || (zstr_len(&query.required) > 0 && all_tries.postings);
+  if (query.dated) {
+    entry_dates_between(&all_tries, query.date_lo, query.date_hi, &candidates);
+  } else if (indexed) {
+    postings_candidates(all_tries.postings, zstr_as_view(&query.required), &candidates);
+  }
 
-    if (zstr_len(&filter_input.text) > 0 && entry->score <= 0.0) {
+  // Scoring pass: streams through the hot columns only
+  fuzzy_reset_matches(&all_tries);
+  size_t count = entry_count(&all_tries);
+  size_t scan = indexed ? candidates.length : count;
+  float *scores = all_tries.score.data;
+  for (size_t k = 0; k < scan; k++) {
+    size_t i = indexed ? candidates.data[k] : k;
+    // Nested directories only show up when searching (and never in size mode)
+    if ((!searching || size_mode) && entry_nested(&all_tries, i)) {
+      continue;
+    }
+    scores[i] = fuzzy_query_score(&all_tries, i, &query);
+    if (searching && scores[i] <= 0.0) {
       continue;
     }
+    vec_push_u32(&filtered, (uint32_t)i);
+  }
 
-    vec_push_TryEntryPtr(&filtered_ptrs, entry);
+  // The greedy scores rank well enough to pick candidates; the best of
+  // them get the optimal alignment. Rescoring only raises scores, so they
+  // stay ahead of the rest: the top is selected, the rest sorted, and the
+  // top sorted once rescored. Queries with operators keep their term scores.
+  if (plain.len > 0 && !size_mode) {
+    size_t top = filtered.length < FUZZY_RESCORE_TOP ? filtered.length : FUZZY_RESCORE_TOP;
+    zsort_nth_by_score(filtered.data, filtered.length, top);
+    zsort_by_score(filtered.data + top, filtered.length - top);
+    for (size_t i = 0; i < top; i++) {
+      fuzzy_rescore(&all_tries, filtered.data[i], plain);
+    }
+    zsort_by_score(filtered.data, top);
+  } else {
+    rank_tries(filtered.data, filtered.length);
   }
 
-  qsort(filtered_ptrs.data, filtered_ptrs.length, sizeof(TryEntry *),
-        compare_tries_by_score);
+  // Few or no matches: probably a typo. Names within a couple of edits go
+  // below the matches, closest first, so a mistyped query still finds the
+  // try instead of offering to create a duplicate.
+  FuzzyTypo typo;
+  size_t matches = filtered.length;
+  if (matches < FUZZY_TYPO_RESULTS && fuzzy_typo_init(&typo, plain)) {
+    vec_u32 hits[FUZZY_TYPO_MAX_EDITS + 1] = {0};
+    for (size_t i = 0; i < count; i++) {
+      if (size_mode && entry_nested(&all_tries, i)) {
+        continue;
+      }
+      // Scores are stale outside the candidates, so look the entry up
+      bool matched = false;
+      for (size_t m = 0; m < matches && !matched; m++) {
+        matched = filtered.data[m] == i;
+      }
+      if (matched) {
+        continue;
+      }
+      int dist = fuzzy_typo_match(&typo, &all_tries, i);
+      if (dist >= 0) {
+        scores[i] = fuzzy_score(&all_tries, i, ZSV(""));
+        vec_push_u32(&hits[dist], (uint32_t)i);
+      }
+    }
+    for (int d = 0; d <= FUZZY_TYPO_MAX_EDITS; d++) {
+      rank_tries(hits[d].data, hits[d].length);
+      if (hits[d].length > 0) {
+        vec_extend_u32(&filtered, hits[d].data, hits[d].length);
+      }
+      vec_free_u32(&hits[d]);
+    }
+  }
 
-  if (selected_index >= (int)filtered_ptrs.length) {
+  if (selected_index >= (int)filtered.length) {
     selected_index = 0;
   }
 }
@@ -261,18 +375,37 @@ static int read_test_key(TestParams *test) {
 }
 
 // Render confirmation dialog for deletion
+// Sizes are measured in the background and filled in as they arrive
 // Returns true if user typed "YES", false otherwise
 static bool render_delete_confirmation(const char *base_path, TestParams *test) {
-  (void)base_path;
-
   // Collect marked items
-  vec_TryEntryPtr marked_items = {0};
-  for (size_t i = 0; i < filtered_ptrs.length; i++) {
-    if (filtered_ptrs.data[i]->marked_for_delete) {
-      vec_push_TryEntryPtr(&marked_items, filtered_ptrs.data[i]);
+  vec_u32 marked_items = {0};
+  for (size_t i = 0; i < filtered.length; i++) {
+    if (entry_marked(&all_tries, filtered.data[i])) {
+      vec_push_u32(&marked_items, filtered.data[i]);
     }
   }
 
+  // Start measuring everything whose size isn't known yet (sizes found by
+  // the walk stay in the store for the rest of the session)
+  size_t count = marked_items.length;
+  uint32_t *walk_entries = calloc(count ? count : 1, sizeof(uint32_t));
+  const char **walk_names = calloc(count ? count : 1, sizeof(char *));
+  size_t walk_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t entry = marked_items.data[i];
+    if (!entry_size(&all_tries, entry)->known) {
+      walk_entries[walk_count] = entry;
+      walk_names[walk_count++] = entry_name(&all_tries, entry);
+    }
+  }
+  DuWalk *walk = walk_count > 0 ? du_start(base_path, walk_names, walk_count) : NULL;
+  bool measuring = walk != NULL;
+  if (test && test->inject_keys) {
+    // Deterministic output for tests: sizes are complete on first render
+    while (walk && !du_done(walk)) poll(NULL, 0, 5);
+  }
+
   TuiInput input = tui_input_init();
   input.placeholder = "YES";
   bool confirmed = false;
@@ -282,6 +415,28 @@ static bool render_delete_confirmation(const char *base_path, TestParams *test)
   if (max_show > (int)marked_items.length) max_show = (int)marked_items.length;
 
   while (1) {
+    // Collect progress (sample completion first so nothing finishes unseen)
+    if (measuring) {
+      measuring = !du_done(walk);
+      for (size_t w = 0; w < walk_count; w++) {
+        EntrySize *sz = entry_size(&all_tries, walk_entries[w]);
+        if (sz->known) continue;
+        DuUsage usage;
+        du_usage(walk, w, &usage);
+        sz->bytes = usage.bytes;
+        sz->files = usage.files;
+        sz->known = usage.done;
+      }
+    }
+
+    uint64_t total = 0;
+    bool all_known = true;
+    for (size_t i = 0; i < count; i++) {
+      const EntrySize *sz = entry_size(&all_tries, marked_items.data[i]);
+      total += sz->bytes;
+      all_known = all_known && sz->known;
+    }
+
     int rows, cols;
     get_window_size(&rows, &cols);
     const char *sep = get_separator_line(cols);
@@ -289,21 +444,34 @@ static bool render_delete_confirmation(const char *base_path, TestParams *test)
     Tui t = tui_begin_screen(stderr);
 
     // Title
+    Z_CLEANUP(zstr_free) zstr total_str = format_size(total);
     TuiStyleString line = tui_screen_line(&t);
     tui_printf(&line, TUI_BOLD, "🗑️  Delete %zu director%s?",
                marked_items.length, marked_items.length == 1 ? "y" : "ies");
+    if (walk || all_known) {
+      tui_printf(&line, TUI_DARK, " (%s%s)", zstr_cstr(&total_str),
+                 all_known ? "" : "…");
+    }
     tui_screen_write(&t, &line);
 
     line = tui_screen_line(&t);
     tui_print(&line, TUI_DARK, sep);
     tui_screen_write(&t, &line);
 
-    // List items
+    // List items, sizes right-aligned
     tui_screen_empty(&t);
     for (int i = 0; i < max_show; i++) {
+      const EntrySize *sz = entry_size(&all_tries, marked_items.data[i]);
+      if (walk || sz->known) {
+        Z_CLEANUP(zstr_free) zstr size_str = format_size(sz->bytes);
+        TuiStyleString ralign = tui_screen_line(&t);
+        tui_printf(&ralign, TUI_DARK, "%s%s ", zstr_cstr(&size_str),
+                   sz->known ? "" : "…");
+        tui_screen_rwrite(&t, &ralign, NULL);
+      }
       line = tui_screen_line(&t);
       tui_print(&line, TUI_DARK, "  - ");
-      tui_print(&line, NULL, zstr_cstr(&marked_items.data[i]->name));
+      tui_print_view(&line, NULL, entry_name_view(&all_tries, marked_items.data[i]));
       tui_screen_write(&t, &line);
     }
     if ((int)marked_items.length > max_show) {
@@ -334,10 +502,19 @@ static bool render_delete_confirmation(const char *base_path, TestParams *test)
 
     tui_free(&t);
 
-    // Read key
-    int c = is_test ? read_test_key(test) : read_key();
+    // Read key; while sizes are still coming in, wake up to redraw them
+    int c;
+    if (is_test) {
+      c = read_test_key(test);
+    } else if (measuring) {
+      c = read_key_timeout(100);
+    } else {
+      c = read_key();
+    }
 
-    if (c == -1 || c == ESC_KEY || c == 3) {
+    if (c == KEY_TIMEOUT || c == KEY_RESIZE) {
+      continue;
+    } else if (c == -1 || c == ESC_KEY || c == 3) {
       break;
     } else if (c == ENTER_KEY) {
       if (strcmp(zstr_cstr(&input.text), "YES") == 0) {
@@ -349,39 +526,119 @@ static bool render_delete_confirmation(const char *base_path, TestParams *test)
     }
   }
 
-  vec_free_TryEntryPtr(&marked_items);
+  du_free(walk);
+  free(walk_entries);
+  free(walk_names);
+  vec_free_u32(&marked_items);
   tui_input_free(&input);
   return confirmed;
 }
 
-// Helper to extract date prefix from entry name
-// Returns length of date prefix (including trailing dash), or 0 if no valid prefix
-static int get_date_prefix_len(const char *name) {
-  // Expected format: YYYY-MM-DD-
-  if (strlen(name) < 11) return 0;
-
-  // Check format: digits, dash, digits, dash, digits, dash
-  for (int i = 0; i < 4; i++) {
-    if (!isdigit((unsigned char)name[i])) return 0;
+// Delete confirmed directories in-process, showing progress while it runs
+// (or move them to the trash, see trash.h).
+// The delete script still carries a guarded `rm -rf` for each name, so
+// anything left behind here is retried (and reported) by the shell.
+static void run_delete(const char *base_path, const vec_zstr *names, bool show_progress) {
+  int dirfd = open(base_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirfd < 0) return;
+
+  const char **list = malloc(names->length * sizeof(char *));
+  if (!list) {
+    close(dirfd);
+    return;
   }
-  if (name[4] != '-') return 0;
-  for (int i = 5; i < 7; i++) {
-    if (!isdigit((unsigned char)name[i])) return 0;
+  for (size_t i = 0; i < names->length; i++) {
+    list[i] = zstr_cstr(&names->data[i]);
   }
-  if (name[7] != '-') return 0;
-  for (int i = 8; i < 10; i++) {
-    if (!isdigit((unsigned char)name[i])) return 0;
+
+  // Trash mode: instant renames now, the real delete in the background
+  if (trash_mode_enabled()) {
+    if (trash_move(base_path, list, names->length) > 0) {
+      trash_purge_async(base_path);
+    }
+    free(list);
+    close(dirfd);
+    return;
   }
-  if (name[10] != '-') return 0;
 
-  return 11;  // "YYYY-MM-DD-" = 11 chars
+  RmTree *rt = rmtree_start(dirfd, list, names->length);
+  while (rt) {
+    RmTreeProgress progress;
+    rmtree_progress(rt, &progress);
+    if (progress.done) break;
+    if (!show_progress) {
+      poll(NULL, 0, 10);
+      continue;
+    }
+
+    int rows, cols;
+    get_window_size(&rows, &cols);
+
+    Tui t = tui_begin_screen(stderr);
+    TuiStyleString line = tui_screen_line(&t);
+    tui_printf(&line, TUI_BOLD, "🗑️  Deleting %zu director%s...",
+               names->length, names->length == 1 ? "y" : "ies");
+    tui_screen_write(&t, &line);
+
+    line = tui_screen_line(&t);
+    tui_print(&line, TUI_DARK, get_separator_line(cols));
+    tui_screen_write(&t, &line);
+
+    tui_screen_empty(&t);
+    line = tui_screen_line(&t);
+    tui_printf(&line, NULL, "  %zu files, %zu directories removed",
+               progress.files, progress.dirs);
+    tui_screen_write(&t, &line);
+    tui_free(&t);
+
+    poll(NULL, 0, 50);
+  }
+
+  if (rt) rmtree_finish(rt);
+  free(list);
+  close(dirfd);
+}
+
+// Unpack an archived try before cd'ing into it, showing progress while the
+// archive streams through the decompressor. Returns true once the directory
+// is back in place.
+static bool run_restore(size_t entry, bool show_progress) {
+  const char *name = entry_name(&all_tries, entry);
+  ArchiveRestore *r = archive_restore_start(entry_root(&all_tries, entry), name);
+  if (!r) return false;
+
+  double fraction = 0.0;
+  while (!archive_restore_done(r, &fraction)) {
+    if (show_progress) {
+      int rows, cols;
+      get_window_size(&rows, &cols);
+
+      Tui t = tui_begin_screen(stderr);
+      TuiStyleString line = tui_screen_line(&t);
+      tui_printf(&line, TUI_BOLD, "📦 Restoring %s...", name);
+      tui_screen_write(&t, &line);
+
+      line = tui_screen_line(&t);
+      tui_print(&line, TUI_DARK, get_separator_line(cols));
+      tui_screen_write(&t, &line);
+
+      tui_screen_empty(&t);
+      line = tui_screen_line(&t);
+      tui_printf(&line, NULL, "  %d%% of the archive extracted", (int)(fraction * 100));
+      tui_screen_write(&t, &line);
+      tui_free(&t);
+    }
+
+    poll(NULL, 0, 50);
+  }
+  return archive_restore_finish(r) == 0;
 }
 
 // Render rename dialog for a single entry
 // Returns the new name (with date prefix), or empty zstr if cancelled
-static zstr render_rename_dialog(TryEntry *entry, TestParams *test) {
-  const char *old_name = zstr_cstr(&entry->name);
-  int prefix_len = get_date_prefix_len(old_name);
+static zstr render_rename_dialog(size_t entry, TestParams *test) {
+  const char *old_name = entry_name(&all_tries, entry);
+  int prefix_len = entry_date(&all_tries, entry) != 0 ? ENTRY_DATE_PREFIX_LEN : 0;
 
   // Extract date prefix and suffix
   Z_CLEANUP(zstr_free) zstr date_prefix = zstr_init();
@@ -486,6 +743,58 @@ static zstr render_rename_dialog(TryEntry *entry, TestParams *test) {
   return result;
 }
 
+// Right-hand pane: listing of the selected directory, then its README
+static void render_preview(Tui *t, int top, int height, int col, int width) {
+  const Preview *p = NULL;
+  bool archived = false;
+  if (selected_index < (int)filtered.length) {
+    size_t entry = filtered.data[selected_index];
+    archived = entry_archived(&all_tries, entry);
+  }
+  if (selected_index < (int)filtered.length && !archived) {
+    size_t entry = filtered.data[selected_index];
+    Z_CLEANUP(zstr_free) zstr path = entry_path(&all_tries, entry);
+    p = preview_get(preview_loader, (uint32_t)entry, zstr_cstr(&path));
+  }
+
+  int readme_rows = 0;
+  if (p && p->readme.length > 0) {
+    readme_rows = (int)p->readme.length + 1;  // Plus its title line
+    if (readme_rows > height / 2)
+      readme_rows = height / 2;
+  }
+  int list_rows = height - readme_rows;
+
+  for (int i = 0; i < height; i++) {
+    TuiStyleString line = tui_screen_line(t);
+    tui_print(&line, TUI_DARK, "│ ");
+    if (archived) {
+      if (i == 0)
+        tui_print(&line, TUI_DARK, "📦 Archived, Enter restores it");
+    } else if (!p) {
+      if (i == 0 && selected_index < (int)filtered.length)
+        tui_print(&line, TUI_DARK, "Loading…");
+    } else if (i < list_rows) {
+      bool truncated = (size_t)list_rows < p->files.length || p->more;
+      if (i == 0 && p->files.length == 0) {
+        tui_print(&line, TUI_DARK, "(empty)");
+      } else if (truncated && i == list_rows - 1) {
+        tui_printf(&line, TUI_DARK, "… %zu%s more", p->files.length - (size_t)i,
+                   p->more ? "+" : "");
+      } else if ((size_t)i < p->files.length) {
+        const zstr *file = &p->files.data[i];
+        bool is_dir = zstr_cstr(file)[zstr_len(file) - 1] == '/';
+        tui_print(&line, is_dir ? TUI_BOLD : NULL, zstr_cstr(file));
+      }
+    } else if (i == list_rows) {
+      tui_printf(&line, TUI_DARK, "── %s ──", zstr_cstr(&p->readme_name));
+    } else if ((size_t)(i - list_rows - 1) < p->readme.length) {
+      tui_print(&line, TUI_DARK, zstr_cstr(&p->readme.data[i - list_rows - 1]));
+    }
+    tui_screen_write_at(t, top + i, col, width, &line);
+  }
+}
+
 static void render(const char *base_path) {
   (void)base_path;
   int rows, cols;
@@ -497,6 +806,11 @@ static void render(const char *base_path) {
   // Header
   TuiStyleString line = tui_screen_line(&t);
   tui_print(&line, TUI_H1, "🏠 Try Directory Selection");
+  size_t pending_roots = root_scan_pending(root_scan);
+  if (pending_roots > 0) {
+    tui_printf(&line, TUI_DARK, "  scanning %zu more root%s…", pending_roots,
+               pending_roots == 1 ? "" : "s");
+  }
   tui_screen_write_truncated(&t, &line, "… ");
 
   line = tui_screen_line(&t);
@@ -524,13 +838,30 @@ static void render(const char *base_path) {
   if (selected_index >= scroll_offset + list_height)
     scroll_offset = selected_index - list_height + 1;
 
+  // Preview pane on the right when enabled and the terminal is wide enough
+  int pane_width = preview_mode && cols >= 80 ? cols * 2 / 5 : 0;
+  int list_top = t.row;
+  if (pane_width > 0)
+    t.cols = cols - pane_width;
+
+  // Only rows on screen get git badges; the worker follows the scroll
+  vec_clear_u32(&visible_rows);
+  for (int i = 0; i < list_height && scroll_offset + i < (int)filtered.length; i++) {
+    vec_push_u32(&visible_rows, filtered.data[scroll_offset + i]);
+  }
+  git_status_want(git_status, &all_tries, visible_rows.data, visible_rows.length);
+  while (git_status_sync && git_status_busy(git_status)) {
+    poll(NULL, 0, 5);
+    git_status_poll(git_status, &all_tries);
+  }
+
   for (int i = 0; i < list_height; i++) {
     int idx = scroll_offset + i;
 
-    if (idx < (int)filtered_ptrs.length) {
-      TryEntry *entry = filtered_ptrs.data[idx];
+    if (idx < (int)filtered.length) {
+      size_t entry = filtered.data[idx];
       bool is_selected = (idx == selected_index);
-      bool is_marked = entry->marked_for_delete;
+      bool is_marked = entry_marked(&all_tries, entry);
 
       // Determine line background
       const char *line_bg = NULL;
@@ -541,12 +872,31 @@ static void render(const char *base_path) {
       }
 
       // Write right-aligned metadata first (will be partially overwritten)
-      Z_CLEANUP(zstr_free) zstr rel_time = format_relative_time(entry->mtime);
       char score_buf[16];
-      snprintf(score_buf, sizeof(score_buf), ", %.1f", entry->score);
+      snprintf(score_buf, sizeof(score_buf), ", %.1f", entry_score(&all_tries, entry));
 
       TuiStyleString ralign = tui_screen_line(&t);
-      tui_print(&ralign, TUI_DARK, zstr_cstr(&rel_time));
+      if (size_mode) {
+        const EntrySize *sz = entry_size(&all_tries, entry);
+        Z_CLEANUP(zstr_free) zstr size_str = format_size(sz->bytes);
+        tui_printf(&ralign, TUI_DARK, "%s%s  ", zstr_cstr(&size_str),
+                   sz->known ? "" : "…");
+      }
+      const EntryGit *git = entry_git(&all_tries, entry);
+      if (git->state >= GIT_REPO && git->branch[0]) {
+        tui_print(&ralign, TUI_DARK, git->branch);
+        if (git->state == GIT_DIRTY)
+          tui_print(&ralign, TUI_HIGHLIGHT, "*");
+        tui_print(&ralign, NULL, "  ");
+      }
+      if (entry_archived(&all_tries, entry)) {
+        tui_print(&ralign, TUI_DARK, "archived  ");
+      }
+      uint32_t root_id = entry_root_id(&all_tries, entry);
+      if (root_id > 0) {
+        tui_printf(&ralign, TUI_DARK, "⌂ %s  ", zstr_cstr(&root_labels.data[root_id]));
+      }
+      tui_print(&ralign, TUI_DARK, entry_age(&all_tries, entry));
       tui_print(&ralign, TUI_DARK, score_buf);
       tui_screen_rwrite(&t, &ralign, line_bg);
 
@@ -555,26 +905,26 @@ static void render(const char *base_path) {
       if (line_bg) tui_push(&line, line_bg);
 
       // Render entry prefix and name
+      const char *icon = is_marked ? "🗑️ " : entry_archived(&all_tries, entry) ? "📦 " : "📁 ";
       if (is_selected) {
         tui_print(&line, TUI_HIGHLIGHT, "→ ");
-        tui_print(&line, NULL, is_marked ? "🗑️ " : "📁 ");
       } else {
-        tui_print(&line, NULL, is_marked ? "  🗑️ " : "  📁 ");
+        tui_print(&line, NULL, "  ");
       }
-      tui_print(&line, NULL, zstr_cstr(&entry->rendered));
+      tui_print(&line, NULL, icon);
+      fuzzy_paint(&line, &all_tries, entry, highlight_matches);
       tui_putc(&line, ' ');  // Trailing space (ignored by truncation)
 
       if (line_bg) tui_pop(&line);
       tui_screen_write_truncated(&t, &line, "… ");
 
-    } else if (idx == (int)filtered_ptrs.length && zstr_len(&filter_input.text) > 0) {
+    } else if (idx == (int)filtered.length && zstr_len(&filter_input.text) > 0) {
       // Separator before "Create new"
       tui_screen_empty(&t);
       i++;
 
-      // Generate preview name
-      time_t now = time(NULL);
-      struct tm *tm = localtime(&now);
+      // Generate preview name (frame time, kept fresh by the main loop)
+      struct tm *tm = localtime(&all_tries.now);
       char date_prefix[20];
       strftime(date_prefix, sizeof(date_prefix), "%Y-%m-%d", tm);
 
@@ -599,6 +949,11 @@ static void render(const char *base_path) {
     }
   }
 
+  if (pane_width > 0) {
+    render_preview(&t, list_top, list_height, cols - pane_width + 1, pane_width);
+    t.cols = cols;
+  }
+
   // Footer
   line = tui_screen_line(&t);
   tui_print(&line, TUI_DARK, sep);
@@ -610,15 +965,44 @@ static void render(const char *base_path) {
     tui_printf(&line, NULL, " | %d marked | ", marked_count);
     tui_print(&line, TUI_DARK, "Ctrl-D: Toggle  Enter: Confirm  Esc: Cancel");
   } else {
-    tui_print(&line, TUI_DARK, "↑/↓: Navigate  Enter: Select  ^R: Rename  ^D: Delete  Esc: Cancel");
+    // The preview hint only when it fits, so Esc stays visible at 80 columns
+    tui_print(&line, TUI_DARK,
+              cols > 88 ? "↑/↓: Navigate  Enter: Select  ^R: Rename  ^D: Delete  ^S: Size  ^O: Preview  Esc: Cancel"
+                        : "↑/↓: Navigate  Enter: Select  ^R: Rename  ^D: Delete  ^S: Size  Esc: Cancel");
   }
   tui_screen_write_truncated(&t, &line, NULL);
   // tui_free(&t) called automatically via Z_CLEANUP
 }
 
-SelectionResult run_selector(const char *base_path,
+// Merges roots that finished scanning, keeping the selection on the same
+// entry. Returns true if the list changed.
+static bool merge_scanned_roots(void) {
+  bool on_entry = selected_index < (int)filtered.length;
+  uint32_t keep = on_entry ? filtered.data[selected_index] : 0;
+  if (!root_scan_poll(root_scan, &all_tries)) {
+    return false;
+  }
+
+  filter_tries();
+  if (!on_entry) {
+    // Stay on "Create new" (or at the top of a list that was empty)
+    selected_index = zstr_len(&filter_input.text) > 0 ? (int)filtered.length : 0;
+    return true;
+  }
+  for (size_t i = 0; i < filtered.length; i++) {
+    if (filtered.data[i] == keep) {
+      selected_index = (int)i;
+      break;
+    }
+  }
+  return true;
+}
+
+SelectionResult run_selector(const vec_zstr *roots,
                              const char *initial_filter,
                              TestParams *test) {
+  const char *base_path = zstr_cstr(&roots->data[0]);
+
   // Initialize filter input
   if (zstr_len(&filter_input.text) == 0 && !filter_input.text.is_long) {
     filter_input = tui_input_init();
@@ -631,14 +1015,28 @@ SelectionResult run_selector(const char *base_path,
     filter_input.cursor = (int)zstr_len(&filter_input.text);
   }
 
-  scan_tries(base_path);
+  // Deterministic output for tests: every root is scanned before the
+  // first frame
+  bool is_test = (test && (test->render_once || test->inject_keys));
+  scan_tries(roots, is_test);
+  for (size_t i = 0; i < roots->length; i++) {
+    vec_push_zstr(&root_labels, root_label(roots, i));
+  }
   filter_tries();
 
-  bool is_test = (test && (test->render_once || test->inject_keys));
+  git_status = git_status_new();
+  git_status_sync = is_test;
+  preview_loader = preview_loader_new(is_test);
 
   // Test mode: render once and exit (only if no keys to inject)
   if (is_test && test->render_once && !test->inject_keys) {
     render(base_path);
+    git_status_free(git_status);
+    git_status = NULL;
+    preview_loader_free(preview_loader);
+    preview_loader = NULL;
+    vec_free_u32(&visible_rows);
+    free_root_state();
     SelectionResult result = {.type = ACTION_CANCEL, .path = zstr_init()};
     return result;
   }
@@ -659,21 +1057,47 @@ SelectionResult run_selector(const char *base_path,
   }
 
   SelectionResult result = {.type = ACTION_CANCEL, .path = zstr_init()};
+  bool restore_failed = false;
 
   while (1) {
+    // One clock read per frame; ages and recency only change per minute
+    bool refilter = entry_store_set_now(&all_tries, time(NULL));
+    // Sizes arriving from the background walker re-sort the size view
+    if (size_refresh_poll(&size_refresh, &all_tries) && size_mode) {
+      refilter = true;
+    }
+    // Slower roots join the list as they finish
+    if (merge_scanned_roots()) {
+      refilter = false;
+      if (size_mode && !size_refresh_active(&size_refresh)) {
+        size_refresh_finish(&size_refresh, &all_tries);
+        size_refresh_start(&size_refresh, &all_tries);
+      }
+    }
+    if (refilter) {
+      filter_tries();
+    }
+    git_status_poll(git_status, &all_tries);
+    preview_poll(preview_loader);
+
     if (!is_test || !test->inject_keys) {
       render(base_path);
     }
 
-    // Read key from injected keys or real input
+    // Read key from injected keys or real input; while sizes, git badges or
+    // a preview are being computed, wake up periodically to show them
     int c;
     if (is_test && test->inject_keys) {
       c = read_test_key(test);
+    } else if (size_refresh_active(&size_refresh) || git_status_busy(git_status) ||
+               (preview_mode && preview_busy(preview_loader)) ||
+               root_scan_pending(root_scan) > 0) {
+      c = read_key_timeout(100);
     } else {
       c = read_key();
     }
 
-    if (c == KEY_RESIZE) {
+    if (c == KEY_RESIZE || c == KEY_TIMEOUT) {
       // Terminal was resized - continue to re-render with new dimensions
       // get_window_size() is called in render() to get updated size
       continue;
@@ -690,35 +1114,55 @@ SelectionResult run_selector(const char *base_path,
     if (c == ESC_KEY || c == 3) {
       // If in delete mode, just clear marks and continue
       if (marked_count > 0) {
-        for (size_t i = 0; i < all_tries.length; i++) {
-          all_tries.data[i].marked_for_delete = false;
+        for (size_t i = 0; i < entry_count(&all_tries); i++) {
+          entry_set_marked(&all_tries, i, false);
         }
         marked_count = 0;
         continue;
       }
       break;
     } else if (c == 4) {
-      // Ctrl-D: Toggle mark on current item
-      if (selected_index < (int)filtered_ptrs.length) {
-        TryEntry *entry = filtered_ptrs.data[selected_index];
-        entry->marked_for_delete = !entry->marked_for_delete;
-        if (entry->marked_for_delete) {
+      // Ctrl-D: Toggle mark on current item (whole tries of the primary root)
+      if (selected_index < (int)filtered.length &&
+          can_modify(filtered.data[selected_index])) {
+        size_t entry = filtered.data[selected_index];
+        entry_set_marked(&all_tries, entry, !entry_marked(&all_tries, entry));
+        if (entry_marked(&all_tries, entry)) {
           marked_count++;
         } else {
           marked_count--;
         }
       }
+    } else if (c == 19) {
+      // Ctrl-S: Toggle size column / sort by size
+      size_mode = !size_mode;
+      if (size_mode && !size_refresh_active(&size_refresh)) {
+        size_refresh_finish(&size_refresh, &all_tries);
+        if (size_refresh_start(&size_refresh, &all_tries) && is_test) {
+          // Deterministic output for tests: wait for the sizes
+          while (size_refresh_active(&size_refresh)) {
+            poll(NULL, 0, 5);
+            size_refresh_poll(&size_refresh, &all_tries);
+          }
+        }
+      }
+      selected_index = 0;
+      filter_tries();
+    } else if (c == 15) {
+      // Ctrl-O: Toggle preview pane
+      preview_mode = !preview_mode;
     } else if (c == 18) {
-      // Ctrl-R: Rename current item
-      if (selected_index < (int)filtered_ptrs.length) {
-        TryEntry *entry = filtered_ptrs.data[selected_index];
+      // Ctrl-R: Rename current item (whole tries of the primary root)
+      if (selected_index < (int)filtered.length &&
+          can_modify(filtered.data[selected_index])) {
+        size_t entry = filtered.data[selected_index];
         zstr new_name = render_rename_dialog(entry, test);
         if (zstr_len(&new_name) > 0) {
           // Check if name actually changed
-          if (strcmp(zstr_cstr(&new_name), zstr_cstr(&entry->name)) != 0) {
+          if (strcmp(zstr_cstr(&new_name), entry_name(&all_tries, entry)) != 0) {
             result.type = ACTION_RENAME;
-            result.path = zstr_dup(&entry->path);
-            result.rename_old_name = zstr_dup(&entry->name);
+            result.path = entry_path(&all_tries, entry);
+            result.rename_old_name = zstr_from(entry_name(&all_tries, entry));
             result.rename_new_name = new_name;
             break;
           }
@@ -733,20 +1177,27 @@ SelectionResult run_selector(const char *base_path,
           // Collect all marked paths
           result.type = ACTION_DELETE;
           // vec_zstr is initialized to 0 via result initialization
-          for (size_t i = 0; i < filtered_ptrs.length; i++) {
-            if (filtered_ptrs.data[i]->marked_for_delete) {
-              vec_push_zstr(&result.delete_names, zstr_dup(&filtered_ptrs.data[i]->name));
+          for (size_t i = 0; i < filtered.length; i++) {
+            if (entry_marked(&all_tries, filtered.data[i])) {
+              vec_push_zstr(&result.delete_names,
+                            zstr_from(entry_name(&all_tries, filtered.data[i])));
             }
           }
+          run_delete(base_path, &result.delete_names, !is_test);
           break;
         }
         // Not confirmed - continue (marks cleared by ESC in dialog, or just continue if typed wrong)
         continue;
       }
 
-      if (selected_index < (int)filtered_ptrs.length) {
+      if (selected_index < (int)filtered.length) {
+        size_t entry = filtered.data[selected_index];
+        if (entry_archived(&all_tries, entry) && !run_restore(entry, !is_test)) {
+          restore_failed = true;
+          break;
+        }
         result.type = ACTION_CD;
-        result.path = zstr_dup(&filtered_ptrs.data[selected_index]->path);
+        result.path = entry_path(&all_tries, entry);
       } else {
         // Create new - validate and normalize name first
         Z_CLEANUP(zstr_free) zstr normalized = normalize_dir_name(zstr_cstr(&filter_input.text));
@@ -773,7 +1224,7 @@ SelectionResult run_selector(const char *base_path,
       if (selected_index > 0)
         selected_index--;
     } else if (c == ARROW_DOWN || c == 14) {  // DOWN or Ctrl-N
-      int max_idx = filtered_ptrs.length;
+      int max_idx = filtered.length;
       if (zstr_len(&filter_input.text) > 0)
         max_idx++;
       if (selected_index < max_idx - 1)
@@ -795,9 +1246,21 @@ SelectionResult run_selector(const char *base_path,
     tui_write_reset(stderr);
     fflush(stderr);
   }
+  if (restore_failed) {
+    fprintf(stderr, "Error: Could not restore %s from its archive\n",
+            entry_name(&all_tries, filtered.data[selected_index]));
+  }
 
+  size_refresh_finish(&size_refresh, &all_tries);
+  size_mode = false;
+  git_status_free(git_status);
+  git_status = NULL;
+  preview_loader_free(preview_loader);
+  preview_loader = NULL;
+  preview_mode = false;
+  vec_free_u32(&visible_rows);
+  free_root_state();
   clear_state();
-  vec_free_TryEntryPtr(&filtered_ptrs);
   tui_input_free(&filter_input);
   marked_count = 0;
 
@@ -21,15 +21,6 @@ typedef enum {
   ACTION_RENAME
 } ActionType;
 
-typedef struct {
-  zstr path;
-  zstr name;
-  zstr rendered;
-  time_t mtime;
-  float score;
-  bool marked_for_delete;
-} TryEntry;
-
 typedef struct {
   ActionType type;
   zstr path;
@@ -45,8 +36,9 @@ typedef struct {
   int key_index;           // Current position in inject_keys
 } TestParams;
 
-// Selector
-SelectionResult run_selector(const char *base_path, const char *initial_filter,
+// Selector over every root in roots; the first one is where new
+// directories are created
+SelectionResult run_selector(const vec_zstr *roots, const char *initial_filter,
                              TestParams *test);
 
 #endif /* TUI_H */
@@ -1,9 +1,13 @@
 #include "tui_style.h"
+#include "simd.h"
 #include "terminal.h"
 #include <ctype.h>
 #include <stdarg.h>
 #include <string.h>
 
+// Global flag for disabling colors, set by main()
+bool tui_no_colors = false;
+
 // ============================================================================
 // Style Parsing
 // ============================================================================
@@ -139,12 +143,16 @@ void tui_pop(TuiStyleString *ss) {
 }
 
 void tui_print(TuiStyleString *ss, const char *style, const char *text) {
+  tui_print_view(ss, style, zstr_view_from(text));
+}
+
+void tui_print_view(TuiStyleString *ss, const char *style, zstr_view text) {
   int flags = 0;
   if (!tui_no_colors && style && *style) {
     flags = tui_style_flags(style);
     zstr_cat(ss->str, style);
   }
-  zstr_cat(ss->str, text);
+  zstr_cat_len(ss->str, text.data, text.len);
   if (flags) {  // flags is 0 when tui_no_colors, so no redundant check needed
     tui_emit_resets(ss, flags);
     tui_reemit_flags(ss, flags);
@@ -262,6 +270,13 @@ static int codepoint_width(unsigned int cp) {
 static int visible_width(const char *s, size_t len) {
   int width = 0;
   for (size_t i = 0; i < len; i++) {
+    // Runs of plain ASCII are a column per byte
+    size_t run = simd_plain_span(s + i, len - i);
+    width += (int)run;
+    i += run;
+    if (i >= len)
+      break;
+
     unsigned char c = (unsigned char)s[i];
     if (c == '\033' && i + 1 < len && s[i + 1] == '[') {
       // Skip ANSI escape sequence
@@ -286,6 +301,15 @@ static int visible_width(const char *s, size_t len) {
 static size_t truncate_at_width(const char *s, size_t len, int max_width) {
   int width = 0;
   for (size_t i = 0; i < len; i++) {
+    // Runs of plain ASCII are a column per byte
+    size_t run = simd_plain_span(s + i, len - i);
+    if (run > (size_t)(max_width - width))
+      return i + (size_t)(max_width - width);
+    width += (int)run;
+    i += run;
+    if (i >= len)
+      break;
+
     unsigned char c = (unsigned char)s[i];
     if (c == '\033' && i + 1 < len && s[i + 1] == '[') {
       // Skip ANSI escape sequence (include it in output)
@@ -391,6 +415,27 @@ void tui_screen_rwrite(Tui *t, TuiStyleString *line, const char *bg) {
   // Note: don't increment row - we stay on the same line
 }
 
+void tui_screen_write_at(Tui *t, int row, int col, int width,
+                         TuiStyleString *line) {
+  // Draws over already written lines (e.g. a side pane), so save the cursor
+  // and come back to where line-by-line output left off
+  if (t->line_has_selection) {
+    tui_pop(line);
+    t->line_has_selection = false;
+  }
+
+  const char *buf = zstr_cstr(&t->line_buf);
+  size_t len = zstr_len(&t->line_buf);
+  size_t end = truncate_at_width(buf, len, width);
+  int pad = width - visible_width(buf, end);
+
+  fprintf(t->file, "\0337\033[%d;%dH", row, col);
+  fwrite(buf, 1, end, t->file);
+  fputs(ANSI_RESET, t->file);
+  fprintf(t->file, "%*s", pad > 0 ? pad : 0, "");
+  fputs("\0338", t->file);
+}
+
 void tui_screen_empty(Tui *t) {
   fputs(ANSI_CLR "\n", t->file);
   t->row++;
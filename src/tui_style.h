@@ -156,6 +156,7 @@ TuiStyleString tui_wrap_zstr(zstr *s);
 void tui_push(TuiStyleString *ss, const char *style);
 void tui_pop(TuiStyleString *ss);
 void tui_print(TuiStyleString *ss, const char *style, const char *text);
+void tui_print_view(TuiStyleString *ss, const char *style, zstr_view text);
 void tui_putc(TuiStyleString *ss, char c);
 void tui_printf(TuiStyleString *ss, const char *style, const char *fmt, ...)
     __attribute__((format(printf, 3, 4)));
@@ -167,6 +168,8 @@ void tui_screen_write(Tui *t, TuiStyleString *line);
 void tui_screen_write_truncated(Tui *t, TuiStyleString *line,
                                 const char *overflow);
 void tui_screen_rwrite(Tui *t, TuiStyleString *line, const char *bg);  // Right-align with optional bg fill
+void tui_screen_write_at(Tui *t, int row, int col, int width,
+                         TuiStyleString *line);  // Clipped/padded to width, cursor restored
 void tui_screen_empty(Tui *t);
 void tui_screen_clear_rest(Tui *t);
 void tui_free(Tui *t);  // Use with Z_CLEANUP(tui_free)
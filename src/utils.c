@@ -1,6 +1,7 @@
 // Feature test macros for cross-platform compatibility
 #if defined(__APPLE__)
 #define _DARWIN_C_SOURCE
+#include <mach-o/dyld.h>
 #else
 #define _GNU_SOURCE
 #endif
@@ -9,6 +10,7 @@
 #include "config.h"
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,6 +19,22 @@
 #include <time.h>
 #include <unistd.h>
 
+bool self_exe_path(char *buf, size_t size) {
+  // /proc/self/exe first (Linux)
+  ssize_t len = readlink("/proc/self/exe", buf, size - 1);
+  if (len != -1) {
+    buf[len] = '\0';
+    return true;
+  }
+#ifdef __APPLE__
+  uint32_t apple_size = (uint32_t)size;
+  if (_NSGetExecutablePath(buf, &apple_size) == 0) {
+    return true;
+  }
+#endif
+  return false;
+}
+
 char *trim(char *str) {
   char *end;
   while (isspace((unsigned char)*str))
@@ -48,6 +66,10 @@ zstr join_path(const char *dir, const char *file) {
 }
 
 zstr get_default_tries_path(void) {
+  const char *env = getenv("TRY_PATH");
+  if (env && env[0])
+    return zstr_from(env);
+
   Z_CLEANUP(zstr_free) zstr home = get_home_dir();
   if (zstr_is_empty(&home))
     return home;
@@ -56,6 +78,33 @@ zstr get_default_tries_path(void) {
   return path;
 }
 
+void split_tries_path(const char *list, vec_zstr *roots) {
+  while (*list) {
+    size_t len = strcspn(list, ":");
+    bool seen = len == 0;
+    zstr *root;
+    vec_foreach(roots, root) {
+      if (zstr_len(root) == len && memcmp(zstr_cstr(root), list, len) == 0)
+        seen = true;
+    }
+    if (!seen)
+      vec_push_zstr(roots, zstr_from_len(list, len));
+    list += len;
+    if (*list == ':')
+      list++;
+  }
+}
+
+zstr join_tries_path(const vec_zstr *roots) {
+  zstr list = zstr_init();
+  for (size_t i = 0; i < roots->length; i++) {
+    if (i > 0)
+      zstr_push(&list, ':');
+    zstr_cat(&list, zstr_cstr(&roots->data[i]));
+  }
+  return list;
+}
+
 bool dir_exists(const char *path) {
   struct stat sb;
   return (stat(path, &sb) == 0 && S_ISDIR(sb.st_mode));
@@ -97,8 +146,38 @@ int mkdir_p(const char *path) {
   return 0;
 }
 
-zstr format_relative_time(time_t mtime) {
-  time_t now = time(NULL);
+static bool write_all(int fd, const void *data, size_t len) {
+  const char *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+int write_file_atomic(const char *path, const void *head, size_t head_len,
+                      const void *body, size_t body_len) {
+  Z_CLEANUP(zstr_free) zstr tmp = zstr_from(path);
+  zstr_fmt(&tmp, ".%d", (int)getpid());
+  int fd = open(zstr_cstr(&tmp), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return -1;
+  bool ok = write_all(fd, head, head_len) && write_all(fd, body, body_len);
+  if (close(fd) != 0)
+    ok = false;
+  if (!ok || rename(zstr_cstr(&tmp), path) != 0) {
+    unlink(zstr_cstr(&tmp));
+    return -1;
+  }
+  return 0;
+}
+
+zstr format_relative_time(time_t mtime, time_t now) {
   double diff = difftime(now, mtime);
   zstr s = zstr_init();
 
@@ -114,6 +193,26 @@ zstr format_relative_time(time_t mtime) {
   return s;
 }
 
+zstr format_size(uint64_t bytes) {
+  static const char units[] = "KMGTP";
+  zstr s = zstr_init();
+  if (bytes < 1024) {
+    zstr_fmt(&s, "%uB", (unsigned)bytes);
+    return s;
+  }
+  double size = (double)bytes / 1024;
+  int unit = 0;
+  while (size >= 1024 && unit < 4) {
+    size /= 1024;
+    unit++;
+  }
+  if (size < 10)
+    zstr_fmt(&s, "%.1f%c", size, units[unit]);
+  else
+    zstr_fmt(&s, "%.0f%c", size, units[unit]);
+  return s;
+}
+
 // Check if a character is valid for directory names
 // Valid: alphanumeric, underscore, hyphen, dot
 static bool is_valid_dir_char(char c) {
@@ -5,6 +5,7 @@
 #include "libs/zvec.h"
 #include "tui.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
 
@@ -21,13 +22,33 @@ static inline void cleanup_free(void *p) { free(*(void **)p); }
 char *trim(char *str); // Operates in-place
 zstr join_path(const char *dir, const char *file);
 zstr get_home_dir(void);
-zstr get_default_tries_path(void);
+zstr get_default_tries_path(void);  // TRY_PATH, else ~/src/tries
+
+// Appends the roots of a colon-separated list ("~/src/tries:/mnt/archive"),
+// skipping empty and repeated entries
+void split_tries_path(const char *list, vec_zstr *roots);
+zstr join_tries_path(const vec_zstr *roots);
 
 // File helpers
+bool self_exe_path(char *buf, size_t size);  // Running binary (not resolved)
 bool dir_exists(const char *path);
 bool file_exists(const char *path);
 int mkdir_p(const char *path);
-zstr format_relative_time(time_t mtime);
+
+// Replaces `path` with head followed by body (either may be empty) through
+// a temp file and rename(), so readers see the old or the new file, never a
+// partial one. Returns 0 on success, -1 on error (the old file is kept).
+int write_file_atomic(const char *path, const void *head, size_t head_len,
+                      const void *body, size_t body_len);
+zstr format_relative_time(time_t mtime, time_t now);
+zstr format_size(uint64_t bytes);  // "512B", "4.0K", "1.2G" (like du -h)
+
+// Nanosecond part of a struct stat's mtime
+#if defined(__APPLE__)
+#define STAT_MTIME_NSEC(sb) ((sb).st_mtimespec.tv_nsec)
+#else
+#define STAT_MTIME_NSEC(sb) ((sb).st_mtim.tv_nsec)
+#endif
 
 // Directory name validation
 // Returns normalized name (spaces -> hyphens, collapse multiples, strip edges)
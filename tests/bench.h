@@ -0,0 +1,34 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Shared bits of the microbenchmarks (bench_*.c, run by `make bench`)
+
+static inline double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// xorshift64: the same inputs on every run
+static inline uint32_t bench_random(void) {
+  static uint64_t state = 0x9E3779B97F4A7C15ULL;
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return (uint32_t)state;
+}
+
+static inline void bench_shuffle(uint32_t *a, size_t n) {
+  for (size_t i = n; i > 1; i--) {
+    size_t j = bench_random() % i;
+    uint32_t t = a[i - 1];
+    a[i - 1] = a[j];
+    a[j] = t;
+  }
+}
+
+#endif // BENCH_H
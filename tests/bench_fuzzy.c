@@ -0,0 +1,77 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "bench.h"
+#include "float_scorer.h"
+#include "fuzzy.h"
+#include <stdio.h>
+
+// ============================================================================
+// Fixed-point scorer against the float one
+// ============================================================================
+//
+// One scoring pass over 200k generated names per query, as typing does,
+// with fuzzy_score() and with the float scorer it replaced. Only
+// fuzzy_score() records the matched positions, so it does a bit more work.
+
+#define COUNT 200000
+#define PASSES 10
+
+static void generate_name(zstr *out) {
+  static const char *const words[] = {
+      "redis", "pool", "connection", "postgres", "thread", "parser", "rust", "api",
+      "gateway", "test", "beta", "project", "cool", "db", "server", "x", "v2", "experiment",
+  };
+  static const char seps[] = "-_. ";
+  zstr_clear(out);
+  if (bench_random() % 2)
+    zstr_fmt(out, "20%02u-%02u-%02u-", 20 + bench_random() % 6, 1 + bench_random() % 12,
+             1 + bench_random() % 28);
+  size_t count = 1 + bench_random() % 5;
+  for (size_t w = 0; w < count; w++) {
+    if (w > 0)
+      zstr_push(out, seps[bench_random() % 4]);
+    zstr_cat(out, words[bench_random() % (sizeof(words) / sizeof(words[0]))]);
+  }
+}
+
+int main(void) {
+  static const char *const queries[] = {"pool", "rds", "connpool", "2025", "redisserver", "xqz"};
+
+  EntryStore store;
+  entry_store_init(&store, "/tmp", 1700000000);
+  zstr name = zstr_init();
+  for (size_t i = 0; i < COUNT; i++) {
+    generate_name(&name);
+    entry_store_push(&store, zstr_as_view(&name), 1700000000);
+  }
+  zstr_free(&name);
+
+  printf("%-12s %12s %12s\n", "query", "float", "fixed");
+  volatile float sink = 0;
+  for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+    zstr_view query = zstr_view_from(queries[q]);
+    double t_float = 0, t_fixed = 0;
+    for (int pass = 0; pass < PASSES; pass++) {
+      double t = bench_now();
+      for (size_t i = 0; i < COUNT; i++)
+        sink += float_score(&store, i, query);
+      t_float += bench_now() - t;
+
+      fuzzy_reset_matches(&store);
+      t = bench_now();
+      for (size_t i = 0; i < COUNT; i++)
+        sink += fuzzy_score(&store, i, query);
+      t_fixed += bench_now() - t;
+    }
+    printf("%-12s %9.2f ms %9.2f ms\n", queries[q], t_float / PASSES * 1e3,
+           t_fixed / PASSES * 1e3);
+  }
+
+  entry_store_free(&store);
+  return 0;
+}
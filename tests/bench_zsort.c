@@ -0,0 +1,80 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "bench.h"
+#include "zvec.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Generated sorts against qsort()
+// ============================================================================
+//
+// Ranks shuffled ids by a random score column (score desc, id asc), as the
+// selector does, with a full sort and with only the first 100 ordered.
+
+static float *scores;
+
+static inline bool ranks_above(uint32_t a, uint32_t b) {
+  return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+}
+
+Z_SORT_GENERATE_IMPL(uint32_t, ranked, ranks_above)
+
+static int compare_ranked(const void *pa, const void *pb) {
+  uint32_t a = *(const uint32_t *)pa, b = *(const uint32_t *)pb;
+  return ranks_above(a, b) ? -1 : ranks_above(b, a) ? 1 : 0;
+}
+
+#define TOP 100
+
+int main(void) {
+  static const size_t sizes[] = {10000, 100000, 1000000};
+  size_t max = sizes[2];
+  scores = malloc(max * sizeof(float));
+  uint32_t *ids = malloc(max * sizeof(uint32_t));
+  uint32_t *work = malloc(max * sizeof(uint32_t));
+
+  printf("%-10s %12s %12s %12s\n", "n", "qsort", "zsort", "top 100");
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    size_t n = sizes[s];
+    int reps = (int)(3000000 / n) + 1;
+    double t_qsort = 0, t_zsort = 0, t_top = 0;
+    for (int r = 0; r < reps; r++) {
+      for (size_t i = 0; i < n; i++) {
+        ids[i] = (uint32_t)i;
+        scores[i] = (float)(bench_random() % 1000000) / 7.0f;
+      }
+      bench_shuffle(ids, n);
+
+      memcpy(work, ids, n * sizeof(uint32_t));
+      double t = bench_now();
+      qsort(work, n, sizeof(uint32_t), compare_ranked);
+      t_qsort += bench_now() - t;
+
+      memcpy(work, ids, n * sizeof(uint32_t));
+      t = bench_now();
+      zsort_ranked(work, n);
+      t_zsort += bench_now() - t;
+
+      memcpy(work, ids, n * sizeof(uint32_t));
+      t = bench_now();
+      zsort_partial_ranked(work, n, TOP);
+      t_top += bench_now() - t;
+    }
+    printf("%-10zu %9.3f ms %9.3f ms %9.3f ms\n", n, t_qsort / reps * 1e3,
+           t_zsort / reps * 1e3, t_top / reps * 1e3);
+  }
+
+  free(work);
+  free(ids);
+  free(scores);
+  return 0;
+}
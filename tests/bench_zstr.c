@@ -0,0 +1,149 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "bench.h"
+#include "simd.h"
+#include "zstr.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// zstr's vectorized paths and the dispatched kernels
+// ============================================================================
+//
+// ns per call on names (24 bytes), long names (64) and preview lines (1024):
+// zstr's case conversion and UTF-8 scans against byte-at-a-time loops, then
+// each simd.h kernel at every level this CPU runs.
+
+static const size_t lengths[] = {24, 64, 1024};
+#define LENGTH_COUNT (sizeof(lengths) / sizeof(lengths[0]))
+#define BYTES_PER_RUN 50000000
+
+static volatile size_t sink;
+
+static void lower_bytewise(char *s, size_t len) {
+  for (size_t i = 0; i < len; i++)
+    s[i] = (char)tolower((unsigned char)s[i]);
+}
+
+static size_t runes_bytewise(const char *p) {
+  size_t count = 0;
+  while (*p) {
+    zstr_next_rune(&p);
+    count++;
+  }
+  return count;
+}
+
+static bool valid_utf8_bytewise(const unsigned char *p) {
+  while (*p) {
+    size_t len = *p < 0x80 ? 1 : (*p & 0xE0) == 0xC0 ? 2 : (*p & 0xF0) == 0xE0 ? 3
+                 : (*p & 0xF8) == 0xF0 ? 4 : 0;
+    if (len == 0)
+      return false;
+    for (size_t i = 1; i < len; i++) {
+      if ((p[i] & 0xC0) != 0x80)
+        return false;
+    }
+    p += len;
+  }
+  return true;
+}
+
+// Mixed-case ASCII name text
+static void fill_text(char *buf, size_t len) {
+  static const char chars[] = "abcdefghIJKLMnopqrs-tuv_wxyz0123";
+  for (size_t i = 0; i < len; i++)
+    buf[i] = chars[bench_random() % 32];
+  buf[len] = '\0';
+}
+
+// Runs `body` reps times (r_ is the repetition), stores ns per run in out
+#define TIME_NS(out, reps, body)                                                              \
+  do {                                                                                        \
+    double t_ = bench_now();                                                                  \
+    for (long r_ = 0; r_ < (reps); r_++) {                                                    \
+      body;                                                                                   \
+    }                                                                                         \
+    (out) = (bench_now() - t_) / (double)(reps) * 1e9;                                        \
+  } while (0)
+
+static void bench_zstr(void) {
+  printf("%-8s %18s %18s %18s\n", "bytes", "lower", "count_runes", "is_valid_utf8");
+  printf("%-8s %18s %18s %18s\n", "", "bytewise / zstr", "bytewise / zstr", "bytewise / zstr");
+  for (size_t l = 0; l < LENGTH_COUNT; l++) {
+    size_t len = lengths[l];
+    long reps = BYTES_PER_RUN / (long)len;
+    char *text = malloc(len + 1);
+    fill_text(text, len);
+    zstr s = zstr_from(text);
+    char *copy = malloc(len + 1);
+
+    double lower_b;
+    TIME_NS(lower_b, reps, memcpy(copy, text, len); lower_bytewise(copy, len);
+                             sink += (size_t)copy[r_ % len]);
+    double lower_z;
+    TIME_NS(lower_z, reps, memcpy(zstr_data(&s), text, len); zstr_to_lower(&s);
+                             sink += (size_t)zstr_cstr(&s)[r_ % len]);
+    double runes_b;
+    TIME_NS(runes_b, reps, sink += runes_bytewise(zstr_cstr(&s)));
+    double runes_z;
+    TIME_NS(runes_z, reps, sink += zstr_count_runes(&s));
+    double utf8_b;
+    TIME_NS(utf8_b, reps, sink += valid_utf8_bytewise((const unsigned char *)zstr_cstr(&s)));
+    double utf8_z;
+    TIME_NS(utf8_z, reps, sink += zstr_is_valid_utf8(&s));
+    printf("%-8zu %8.1f / %7.1f %8.1f / %7.1f %8.1f / %7.1f\n", len, lower_b, lower_z,
+           runes_b, runes_z, utf8_b, utf8_z);
+
+    zstr_free(&s);
+    free(copy);
+    free(text);
+  }
+}
+
+static void bench_kernels(void) {
+  static const char *const level_names[] = {"scalar", "sse4.2", "avx2", "avx512", "neon"};
+  printf("\n%-8s %-8s %12s %12s %12s %12s\n", "level", "bytes", "lower", "plain_span",
+         "charset_scan", "find");
+  for (size_t v = 0; v < sizeof(level_names) / sizeof(level_names[0]); v++) {
+    setenv("TRY_SIMD", level_names[v], 1);
+    simd_init();
+    if (strcmp(simd_level_name(simd.level), level_names[v]) != 0)
+      continue;
+    for (size_t l = 0; l < LENGTH_COUNT; l++) {
+      size_t len = lengths[l];
+      long reps = BYTES_PER_RUN / (long)len;
+      char *text = malloc(len + 1);
+      fill_text(text, len);
+      SimdCharset cs;
+      simd_charset_init(&cs, "conpl", 5);
+
+      double lower;
+    TIME_NS(lower, reps, simd_lower(text, len); sink += (size_t)text[r_ % len]);
+      double span;
+    TIME_NS(span, reps, sink += simd_plain_span(text, len));
+      double scan;
+    TIME_NS(scan, reps, sink += (size_t)simd_charset_scan(&cs, text, len));
+      double find;
+    TIME_NS(find, reps, sink += (size_t)simd_find(text, len, "zzq", 3));
+      printf("%-8s %-8zu %9.1f ns %9.1f ns %9.1f ns %9.1f ns\n", level_names[v], len, lower,
+             span, scan, find);
+      free(text);
+    }
+  }
+  unsetenv("TRY_SIMD");
+  simd_init();
+}
+
+int main(void) {
+  bench_zstr();
+  bench_kernels();
+  return 0;
+}
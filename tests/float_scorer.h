@@ -0,0 +1,46 @@
+#ifndef FLOAT_SCORER_H
+#define FLOAT_SCORER_H
+
+#include "entries.h"
+#include <ctype.h>
+#include <math.h>
+
+// The greedy scorer as it was before the fixed-point one: float sums,
+// isalnum() on the previous byte for word boundaries and sqrt() for every
+// proximity bonus. fuzzy_score() must keep its matches and ordering (see
+// test_fuzzy.c, bench_fuzzy.c). Returns the score without the recency
+// bonuses, 0 on a miss.
+static inline float float_score(const EntryStore *store, size_t idx, zstr_view query_lower) {
+  zstr_view name = entry_lower_view(store, idx);
+  const char *text = name.data;
+  int text_len = (int)name.len;
+  size_t query_len = query_lower.len;
+  size_t query_idx = 0;
+  int last_pos = -1;
+  float score = 0.0;
+
+  char first = query_lower.data[0];
+  int start = 0;
+  if (entry_date(store, idx) != 0 && !isdigit((unsigned char)first) && first != '-')
+    start = ENTRY_DATE_PREFIX_LEN;
+
+  for (int pos = start; pos < text_len && query_idx < query_len; pos++) {
+    if (text[pos] != query_lower.data[query_idx])
+      continue;
+    score += 1.0;
+    if (pos == 0 || !isalnum((unsigned char)text[pos - 1]))
+      score += 1.0;
+    if (last_pos >= 0)
+      score += 2.0 / sqrt(pos - last_pos);
+    last_pos = pos;
+    query_idx++;
+  }
+  if (query_idx < query_len)
+    return 0.0;
+
+  score *= (float)query_len / (last_pos + 1);
+  score *= 10.0 / (text_len + 10.0);
+  return score + (entry_date(store, idx) != 0 ? 2.0f : 0.0f);
+}
+
+#endif // FLOAT_SCORER_H
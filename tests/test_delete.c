@@ -0,0 +1,135 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "acutest.h"
+#include "zstr.h"
+#include <dirent.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ============================================================================
+// Ctrl-D deletes, end to end
+// ============================================================================
+//
+// Runs the built binary (TRY_BIN) with injected keys the way the shell
+// wrapper does, then evals the printed script with bash: the delete has to
+// succeed, leave the other tries alone and exit 0.
+
+#define DELETE_KEYS "doomed,CTRL-D,DOWN,CTRL-D,ENTER,YES,ENTER"
+
+static bool exists(const char *root, const char *name) {
+  Z_CLEANUP(zstr_free) zstr path = zstr_init();
+  zstr_fmt(&path, "%s/%s", root, name);
+  struct stat sb;
+  return stat(zstr_cstr(&path), &sb) == 0;
+}
+
+static void make_dir(const char *root, const char *name) {
+  Z_CLEANUP(zstr_free) zstr path = zstr_init();
+  zstr_fmt(&path, "%s/%s", root, name);
+  mkdir(zstr_cstr(&path), 0755);
+}
+
+// A tries root with two directories to delete (one nested, with files) and
+// one to keep
+static zstr make_root(void) {
+  char tmpl[] = "/tmp/try-delete-XXXXXX";
+  zstr root = zstr_from(mkdtemp(tmpl));
+  make_dir(zstr_cstr(&root), "doomed-one");
+  make_dir(zstr_cstr(&root), "doomed-one/src");
+  make_dir(zstr_cstr(&root), "doomed-two");
+  make_dir(zstr_cstr(&root), "keeper");
+  for (int i = 0; i < 20; i++) {
+    Z_CLEANUP(zstr_free) zstr file = zstr_init();
+    zstr_fmt(&file, "%s/doomed-one/src/f%d", zstr_cstr(&root), i);
+    FILE *f = fopen(zstr_cstr(&file), "w");
+    if (f)
+      fclose(f);
+  }
+  return root;
+}
+
+static void remove_root(const zstr *root) {
+  Z_CLEANUP(zstr_free) zstr cmd = zstr_init();
+  zstr_fmt(&cmd, "rm -rf '%s'", zstr_cstr(root));
+  TEST_CHECK(system(zstr_cstr(&cmd)) == 0);
+}
+
+// Runs the selector, then bash on its script. Returns bash's exit status.
+static int run_delete(const zstr *root) {
+  Z_CLEANUP(zstr_free) zstr script = zstr_init();
+  zstr_fmt(&script, "%s.sh", zstr_cstr(root));
+
+  Z_CLEANUP(zstr_free) zstr cmd = zstr_init();
+  zstr_fmt(&cmd, "%s --path '%s' --and-keys '%s' exec >'%s' 2>/dev/null", TRY_BIN,
+           zstr_cstr(root), DELETE_KEYS, zstr_cstr(&script));
+  if (!TEST_CHECK(system(zstr_cstr(&cmd)) == 0))
+    return -1;
+
+  zstr_clear(&cmd);
+  zstr_fmt(&cmd, "bash '%s' >/dev/null 2>&1", zstr_cstr(&script));
+  int status = system(zstr_cstr(&cmd));
+  unlink(zstr_cstr(&script));
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static size_t count_entries(const char *path) {
+  DIR *dir = opendir(path);
+  if (!dir)
+    return 0;
+  size_t count = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL)
+    count += strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0;
+  closedir(dir);
+  return count;
+}
+
+void test_delete(void) {
+  zstr root = make_root();
+  unsetenv("TRY_DELETE_MODE");
+
+  TEST_CHECK(run_delete(&root) == 0);
+  TEST_CHECK(!exists(zstr_cstr(&root), "doomed-one"));
+  TEST_CHECK(!exists(zstr_cstr(&root), "doomed-two"));
+  TEST_CHECK(exists(zstr_cstr(&root), "keeper"));
+
+  remove_root(&root);
+  zstr_free(&root);
+}
+
+void test_delete_to_trash(void) {
+  zstr root = make_root();
+  setenv("TRY_DELETE_MODE", "trash", 1);
+
+  TEST_CHECK(run_delete(&root) == 0);
+  TEST_CHECK(!exists(zstr_cstr(&root), "doomed-one"));
+  TEST_CHECK(!exists(zstr_cstr(&root), "doomed-two"));
+  TEST_CHECK(exists(zstr_cstr(&root), "keeper"));
+
+  // The background purge empties the trash
+  Z_CLEANUP(zstr_free) zstr trash = zstr_init();
+  zstr_fmt(&trash, "%s/.trash", zstr_cstr(&root));
+  for (int i = 0; i < 100 && count_entries(zstr_cstr(&trash)) > 0; i++)
+    poll(NULL, 0, 50);
+  TEST_CHECK(count_entries(zstr_cstr(&trash)) == 0);
+
+  unsetenv("TRY_DELETE_MODE");
+  remove_root(&root);
+  zstr_free(&root);
+}
+
+TEST_LIST = {
+    {"delete", test_delete},
+    {"delete to trash", test_delete_to_trash},
+    {NULL, NULL},
+};
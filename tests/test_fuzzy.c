@@ -0,0 +1,258 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "acutest.h"
+#include "float_scorer.h"
+#include "fuzzy.h"
+#include <math.h>
+#include <string.h>
+
+// ============================================================================
+// Fixed-point scorer against the float one
+// ============================================================================
+
+#define NOW 1700000000
+
+// Fresh store of the names, without recency bonuses so scores are the match
+// score alone
+static void fill_store(EntryStore *store, const char *const *names, size_t count) {
+  entry_store_init(store, "/tmp", NOW);
+  for (size_t i = 0; i < count; i++) {
+    entry_store_push(store, zstr_view_from(names[i]), NOW);
+    store->recency.data[i] = 0.0f;
+  }
+}
+
+static size_t find_name(const EntryStore *store, const char *name) {
+  for (size_t i = 0; i < entry_count(store); i++) {
+    if (strcmp(entry_name(store, i), name) == 0)
+      return i;
+  }
+  return SIZE_MAX;
+}
+
+static const char *const names[] = {
+    "2025-11-28-redis-connection-pool",
+    "2025-11-03-thread-pool",
+    "2025-10-22-db-pooling",
+    "2025-01-02-postgres-connection-pool",
+    "notes",
+    "alpha",
+    "beta",
+    "2024-05-05-beta-test",
+    "Project_X",
+    "rust-parser",
+    "my_cool_project",
+    "api-gateway-v2",
+    "2023-12-31-new-years-eve",
+    "2024-02-02-a-really-long-experiment-name-that-keeps-going-past-sixty-four-bytes-pool",
+};
+
+#define NAME_COUNT (sizeof(names) / sizeof(names[0]))
+#define LONG_NAME "2024-02-02-a-really-long-experiment-name-that-keeps-going-past-sixty-four-bytes-pool"
+
+// Scores of the float scorer, rounded to 4 places
+static const struct {
+  const char *name;
+  const char *query;
+  float score;
+} golden[] = {
+    {"2025-11-28-redis-connection-pool", "pool", 2.3274f},
+    {"2025-11-03-thread-pool", "pool", 2.6250f},
+    {"2025-10-22-db-pooling", "pool", 2.7885f},
+    {"2025-01-02-postgres-connection-pool", "pool", 2.2088f},
+    {LONG_NAME, "pool", 2.0275f},
+    {"notes", "pool", 0.0f},
+    {"2025-11-28-redis-connection-pool", "rds", 2.3048f},
+    {"rust-parser", "rds", 0.0f},
+    {"2025-11-28-redis-connection-pool", "connpool", 3.3516f},
+    {"2025-01-02-postgres-connection-pool", "connpool", 3.1534f},
+    {"beta", "beta", 7.8571f},
+    {"2024-05-05-beta-test", "beta", 2.9778f},
+    {"alpha", "beta", 0.0f},
+    {"Project_X", "proj", 5.7895f},
+    {"my_cool_project", "proj", 1.4667f},
+    {"2025-11-28-redis-connection-pool", "2025", 4.6190f},
+    {"2025-11-03-thread-pool", "2025", 5.4375f},
+    {"2025-10-22-db-pooling", "2025", 5.5484f},
+    {"2025-01-02-postgres-connection-pool", "2025", 4.4444f},
+    {"2024-05-05-beta-test", "2025", 3.9048f},
+    {"Project_X", "x", 0.1170f},
+    {LONG_NAME, "x", 2.0039f},
+    {"2025-11-28-redis-connection-pool", "cpool", 2.5061f},
+    {"2025-01-02-postgres-connection-pool", "cpool", 2.4318f},
+    {"api-gateway-v2", "gw", 0.3704f},
+    {"2025-10-22-db-pooling", "pooling", 4.1505f},
+    {"2023-12-31-new-years-eve", "new", 2.5042f},
+    {"2025-01-02-postgres-connection-pool", "ps", 2.1401f},
+    {"rust-parser", "ps", 0.4397f},
+    {LONG_NAME, "ps", 2.0101f},
+};
+
+void test_golden_scores(void) {
+  EntryStore store;
+  fill_store(&store, names, NAME_COUNT);
+  for (size_t i = 0; i < sizeof(golden) / sizeof(golden[0]); i++) {
+    size_t idx = find_name(&store, golden[i].name);
+    float score = fuzzy_score(&store, idx, zstr_view_from(golden[i].query));
+    if (!TEST_CHECK(fabsf(score - golden[i].score) < 1e-4f))
+      TEST_MSG("%s / %s: %.6f, expected %.4f", golden[i].name, golden[i].query, score,
+               golden[i].score);
+  }
+  entry_store_free(&store);
+}
+
+// Matches of a query, best first
+static const struct {
+  const char *query;
+  const char *ranking[6];
+} golden_rankings[] = {
+    {"pool",
+     {"2025-10-22-db-pooling", "2025-11-03-thread-pool", "2025-11-28-redis-connection-pool",
+      "2025-01-02-postgres-connection-pool", LONG_NAME}},
+    {"2025",
+     {"2025-10-22-db-pooling", "2025-11-03-thread-pool", "2025-11-28-redis-connection-pool",
+      "2025-01-02-postgres-connection-pool", "2024-05-05-beta-test"}},
+    {"beta", {"beta", "2024-05-05-beta-test"}},
+    {"proj", {"Project_X", "my_cool_project"}},
+    {"ps", {"2025-01-02-postgres-connection-pool", LONG_NAME, "rust-parser"}},
+};
+
+void test_golden_rankings(void) {
+  EntryStore store;
+  fill_store(&store, names, NAME_COUNT);
+  for (size_t g = 0; g < sizeof(golden_rankings) / sizeof(golden_rankings[0]); g++) {
+    zstr_view query = zstr_view_from(golden_rankings[g].query);
+    TEST_CASE(golden_rankings[g].query);
+
+    // Selection sort by score desc, id asc: the list is tiny
+    bool taken[NAME_COUNT] = {0};
+    for (size_t rank = 0;; rank++) {
+      size_t best = SIZE_MAX;
+      float best_score = 0.0f;
+      for (size_t i = 0; i < NAME_COUNT; i++) {
+        float score = fuzzy_score(&store, i, query);
+        if (!taken[i] && score > best_score) {
+          best = i;
+          best_score = score;
+        }
+      }
+      const char *want = rank < 6 ? golden_rankings[g].ranking[rank] : NULL;
+      const char *got = best == SIZE_MAX ? NULL : entry_name(&store, best);
+      if (!TEST_CHECK(want == got || (want && got && strcmp(want, got) == 0))) {
+        TEST_MSG("rank %zu: %s, expected %s", rank, got ? got : "(end)", want ? want : "(end)");
+        break;
+      }
+      if (!got)
+        break;
+      taken[best] = true;
+    }
+  }
+  entry_store_free(&store);
+}
+
+// Generated names: words joined by mixed separators, some date-prefixed,
+// some past the 64 bytes of precomputed word starts and some with gaps past
+// the proximity table
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t next_random(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return (uint32_t)rng;
+}
+
+static void generate_name(zstr *out) {
+  static const char *const words[] = {
+      "redis", "pool", "connection", "postgres", "thread", "parser", "rust", "api",
+      "gateway", "test", "beta", "Project", "cool", "db", "server", "X", "v2", "exp",
+  };
+  static const char seps[] = "-_. ";
+  zstr_clear(out);
+  if (next_random() % 2)
+    zstr_fmt(out, "20%02u-%02u-%02u-", 20 + next_random() % 6, 1 + next_random() % 12,
+             1 + next_random() % 28);
+  size_t count = 1 + next_random() % (next_random() % 8 == 0 ? 16 : 4);
+  for (size_t w = 0; w < count; w++) {
+    if (w > 0)
+      zstr_push(out, seps[next_random() % 4]);
+    zstr_cat(out, words[next_random() % (sizeof(words) / sizeof(words[0]))]);
+  }
+  if (next_random() % 50 == 0) {
+    zstr_push(out, 'z');
+    for (int i = 0; i < 300; i++)
+      zstr_push(out, '.');
+    zstr_cat(out, "-pool");
+  }
+}
+
+#define COUNT 20000
+
+static float reference[COUNT];
+
+static inline bool ranks_by_reference(uint32_t a, uint32_t b) {
+  return reference[a] > reference[b] || (reference[a] == reference[b] && a < b);
+}
+
+Z_SORT_GENERATE_IMPL(uint32_t, by_reference, ranks_by_reference)
+
+void test_matches_float_scorer(void) {
+  static const char *const queries[] = {
+      "pool", "rds", "connpool", "2025", "redisserver", "xqz", "p", "x",
+      "beta", "proj", "rp", "2023-1", "-", "tt", "apigw", "zpool",
+  };
+  EntryStore store;
+  entry_store_init(&store, "/tmp", NOW);
+  zstr name = zstr_init();
+  for (size_t i = 0; i < COUNT; i++) {
+    generate_name(&name);
+    entry_store_push(&store, zstr_as_view(&name), NOW);
+    store.recency.data[i] = 0.0f;
+  }
+  zstr_free(&name);
+
+  static float fixed[COUNT];
+  static uint32_t order[COUNT];
+  for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+    zstr_view query = zstr_view_from(queries[q]);
+    TEST_CASE(queries[q]);
+    fuzzy_reset_matches(&store);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+      fixed[i] = fuzzy_score(&store, i, query);
+      reference[i] = float_score(&store, i, query);
+      bool same = (fixed[i] > 0) == (reference[i] > 0) &&
+                  fabsf(fixed[i] - reference[i]) <= 1e-5f * fmaxf(1.0f, reference[i]);
+      if (!same && mismatches++ < 5)
+        TEST_MSG("%s: %.6f, float %.6f", entry_name(&store, i), fixed[i], reference[i]);
+    }
+    TEST_CHECK(mismatches == 0);
+
+    // Walking the float ranking, neighbours it orders apart by more than
+    // rounding noise stay in that order
+    for (size_t i = 0; i < COUNT; i++)
+      order[i] = (uint32_t)i;
+    zsort_by_reference(order, COUNT);
+    size_t inversions = 0;
+    for (size_t i = 0; i + 1 < COUNT; i++) {
+      uint32_t a = order[i], b = order[i + 1];
+      if (reference[a] - reference[b] > 1e-5f && !(fixed[a] > fixed[b]))
+        inversions++;
+    }
+    TEST_CHECK(inversions == 0);
+  }
+  entry_store_free(&store);
+}
+
+TEST_LIST = {
+    {"golden scores", test_golden_scores},
+    {"golden rankings", test_golden_rankings},
+    {"matches float scorer", test_matches_float_scorer},
+    {NULL, NULL},
+};
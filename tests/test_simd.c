@@ -0,0 +1,329 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "acutest.h"
+#include "simd.h"
+#include "zstr.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Vector kernels against the scalar ones
+// ============================================================================
+//
+// Every level TRY_SIMD can select is installed in turn and checked against
+// the scalar kernels on inputs of every length up to a few 64-byte blocks,
+// at every alignment within a 16-byte lane. Inputs are copied into buffers
+// of exactly their length, so a build with -fsanitize=address also catches
+// reads past the end.
+
+#define MAX_LEN 200
+
+static const char *const level_names[] = {"sse4.2", "avx2", "avx512", "neon"};
+#define LEVEL_COUNT (sizeof(level_names) / sizeof(level_names[0]))
+
+static SimdKernels scalar;
+static SimdKernels levels[LEVEL_COUNT];
+static bool level_ok[LEVEL_COUNT];
+
+static void install_levels(void) {
+  setenv("TRY_SIMD", "scalar", 1);
+  simd_init();
+  scalar = simd;
+  for (size_t l = 0; l < LEVEL_COUNT; l++) {
+    setenv("TRY_SIMD", level_names[l], 1);
+    simd_init();
+    // A level the CPU lacks falls back to a lower one, tested on its own
+    level_ok[l] = strcmp(simd_level_name(simd.level), level_names[l]) == 0;
+    levels[l] = simd;
+  }
+  unsetenv("TRY_SIMD");
+  simd_init();
+}
+
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t next_random(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return (uint32_t)rng;
+}
+
+// Mostly letters around the case boundaries, some ESC and non-ASCII bytes
+static char random_byte(void) {
+  static const char edges[] = "@AZ[`az{09-_ ";
+  uint32_t r = next_random() % 100;
+  if (r < 60)
+    return edges[next_random() % (sizeof(edges) - 1)];
+  if (r < 90)
+    return (char)(' ' + next_random() % 95);
+  if (r < 93)
+    return '\033';
+  return (char)(0x80 + next_random() % 128);
+}
+
+// Copy of `len` bytes of src in a block of exactly len + skew bytes, at
+// `skew` past malloc()'s 16-byte alignment
+static char *place(const char *src, size_t len, size_t skew, char **block) {
+  *block = malloc(len + skew + (len + skew == 0));
+  memcpy(*block + skew, src, len);
+  return *block + skew;
+}
+
+void test_levels_available(void) {
+  install_levels();
+  // The level picked without TRY_SIMD is one of the tested ones
+  bool picked = simd.level == SIMD_SCALAR;
+  for (size_t l = 0; l < LEVEL_COUNT; l++)
+    picked |= level_ok[l] && strcmp(simd_level_name(simd.level), level_names[l]) == 0;
+  TEST_CHECK(picked);
+  TEST_CHECK(scalar.level == SIMD_SCALAR);
+}
+
+void test_lower(void) {
+  install_levels();
+  char src[MAX_LEN], want[MAX_LEN];
+  for (size_t len = 0; len <= MAX_LEN; len++) {
+    for (size_t skew = 0; skew < 16; skew += 3) {
+      for (size_t i = 0; i < len; i++)
+        src[i] = random_byte();
+      memcpy(want, src, len);
+      scalar.lower(want, len);
+      for (size_t l = 0; l < LEVEL_COUNT; l++) {
+        if (!level_ok[l])
+          continue;
+        char *block;
+        char *got = place(src, len, skew, &block);
+        levels[l].lower(got, len);
+        if (!TEST_CHECK(memcmp(got, want, len) == 0))
+          TEST_MSG("%s: len %zu, skew %zu", level_names[l], len, skew);
+        free(block);
+      }
+    }
+  }
+}
+
+void test_plain_span(void) {
+  install_levels();
+  char src[MAX_LEN];
+  for (size_t len = 0; len <= MAX_LEN; len++) {
+    // A stop byte at every position, and none
+    for (size_t stop = 0; stop <= len; stop++) {
+      for (size_t i = 0; i < len; i++)
+        src[i] = (char)(' ' + next_random() % 95);
+      if (stop < len)
+        src[stop] = next_random() % 2 ? '\033' : (char)(0x80 + next_random() % 128);
+      size_t want = scalar.plain_span(src, len);
+      for (size_t l = 0; l < LEVEL_COUNT; l++) {
+        if (!level_ok[l])
+          continue;
+        char *block;
+        char *at = place(src, len, stop % 16, &block);
+        size_t got = levels[l].plain_span(at, len);
+        if (!TEST_CHECK(got == want))
+          TEST_MSG("%s: len %zu, stop %zu: %zu, expected %zu", level_names[l], len, stop, got,
+                   want);
+        free(block);
+      }
+    }
+  }
+}
+
+void test_charset_scan(void) {
+  install_levels();
+  char src[MAX_LEN], set_bytes[80];
+  for (int round = 0; round < 400; round++) {
+    // Small sets like a query's letters up to a full 64-byte one
+    size_t set_len = 1 + next_random() % (round % 4 == 0 ? 80 : 8);
+    for (size_t i = 0; i < set_len; i++)
+      set_bytes[i] = random_byte();
+    SimdCharset cs;
+    simd_charset_init(&cs, set_bytes, set_len);
+
+    for (size_t len = 0; len <= MAX_LEN; len += 1 + (round % 3 == 0)) {
+      for (size_t i = 0; i < len; i++)
+        src[i] = next_random() % 8 ? random_byte() : (char)cs.bytes[next_random() % cs.count];
+      uint64_t want = scalar.charset_scan(&cs, src, len);
+      for (size_t l = 0; l < LEVEL_COUNT; l++) {
+        if (!level_ok[l])
+          continue;
+        char *block;
+        char *at = place(src, len, (size_t)round % 16, &block);
+        uint64_t got = levels[l].charset_scan(&cs, at, len);
+        if (!TEST_CHECK(got == want))
+          TEST_MSG("%s: len %zu, %zu bytes in set", level_names[l], len, cs.count);
+        free(block);
+      }
+    }
+  }
+}
+
+void test_find(void) {
+  install_levels();
+  char hay[MAX_LEN], needle[80];
+  for (size_t n = 0; n <= MAX_LEN; n++) {
+    for (int round = 0; round < 24; round++) {
+      // A small alphabet, so partial matches are common
+      for (size_t i = 0; i < n; i++)
+        hay[i] = "aab-"[next_random() % 4];
+      size_t m = next_random() % (round < 12 ? 4 : 72);
+      if (n && round % 2 == 0) {
+        size_t from = next_random() % n;
+        for (size_t i = 0; i < m; i++)
+          needle[i] = from + i < n ? hay[from + i] : 'a';
+      } else {
+        for (size_t i = 0; i < m; i++)
+          needle[i] = "aab-"[next_random() % 4];
+      }
+      const char *found = scalar.find(hay, n, needle, m);
+      ptrdiff_t want = found ? found - hay : -1;
+      for (size_t l = 0; l < LEVEL_COUNT; l++) {
+        if (!level_ok[l])
+          continue;
+        char *hay_block, *needle_block;
+        char *at = place(hay, n, (size_t)round % 16, &hay_block);
+        char *nd = place(needle, m, 0, &needle_block);
+        found = levels[l].find(at, n, nd, m);
+        ptrdiff_t got = found ? found - at : -1;
+        if (!TEST_CHECK(got == want))
+          TEST_MSG("%s: hay %zu, needle %zu: %td, expected %td", level_names[l], n, m, got, want);
+        free(hay_block);
+        free(needle_block);
+      }
+    }
+  }
+}
+
+// ============================================================================
+// zstr's vectorized paths against byte-at-a-time loops
+// ============================================================================
+
+static size_t runes_bytewise(const char *p) {
+  size_t count = 0;
+  while (*p) {
+    zstr_next_rune(&p);
+    count++;
+  }
+  return count;
+}
+
+static bool valid_utf8_bytewise(const unsigned char *p) {
+  while (*p) {
+    size_t len = *p < 0x80 ? 1 : (*p & 0xE0) == 0xC0 ? 2 : (*p & 0xF0) == 0xE0 ? 3
+                 : (*p & 0xF8) == 0xF0 ? 4 : 0;
+    if (len == 0)
+      return false;
+    for (size_t i = 1; i < len; i++) {
+      if ((p[i] & 0xC0) != 0x80)
+        return false;
+    }
+    if ((len == 2 && p[0] < 0xC2) || (len == 3 && p[0] == 0xE0 && p[1] < 0xA0) ||
+        (len == 3 && p[0] == 0xED && p[1] >= 0xA0) || (len == 4 && p[0] > 0xF4) ||
+        (len == 4 && p[0] == 0xF0 && p[1] < 0x90) || (len == 4 && p[0] == 0xF4 && p[1] >= 0x90))
+      return false;
+    p += len;
+  }
+  return true;
+}
+
+// ASCII runs with valid, overlong, surrogate and stray UTF-8 sequences
+static void random_text(char *out, size_t len) {
+  static const char *const seqs[] = {
+      "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xC0\xAF", "\xED\xA0\x80",
+      "\xE0\x80\xAF", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\x80", "\xBF",
+  };
+  size_t i = 0;
+  while (i < len) {
+    if (next_random() % 10 == 0) {
+      const char *seq = seqs[next_random() % (sizeof(seqs) / sizeof(seqs[0]))];
+      size_t n = strlen(seq);
+      // A sequence cut off by the end of the string would be read past its NUL
+      if (i + n > len)
+        break;
+      memcpy(out + i, seq, n);
+      i += n;
+    } else {
+      out[i++] = (char)(' ' + next_random() % 95);
+    }
+  }
+  while (i < len)
+    out[i++] = 'a';
+}
+
+void test_zstr_case(void) {
+  char src[MAX_LEN];
+  for (size_t len = 0; len <= MAX_LEN; len++) {
+    for (int round = 0; round < 8; round++) {
+      for (size_t i = 0; i < len; i++)
+        src[i] = random_byte();
+      zstr lower = zstr_from_len(src, len), upper = zstr_from_len(src, len);
+      zstr_to_lower(&lower);
+      zstr_to_upper(&upper);
+      bool same = true;
+      for (size_t i = 0; i < len; i++) {
+        same &= zstr_cstr(&lower)[i] == (char)tolower((unsigned char)src[i]);
+        same &= zstr_cstr(&upper)[i] == (char)toupper((unsigned char)src[i]);
+      }
+      if (!TEST_CHECK(same))
+        TEST_MSG("len %zu", len);
+      zstr_free(&lower);
+      zstr_free(&upper);
+    }
+  }
+}
+
+void test_zstr_utf8(void) {
+  char src[MAX_LEN];
+  for (size_t len = 0; len <= MAX_LEN; len++) {
+    for (int round = 0; round < 16; round++) {
+      random_text(src, len);
+      zstr s = zstr_from_len(src, len);
+      const char *c = zstr_cstr(&s);
+      if (!TEST_CHECK(zstr_count_runes(&s) == runes_bytewise(c)))
+        TEST_MSG("runes, len %zu", len);
+      if (!TEST_CHECK(zstr_is_valid_utf8(&s) == valid_utf8_bytewise((const unsigned char *)c)))
+        TEST_MSG("valid, len %zu", len);
+      zstr_free(&s);
+    }
+  }
+}
+
+void test_zstr_find(void) {
+  char hay[MAX_LEN + 1], needle[40];
+  for (size_t n = 0; n <= MAX_LEN; n++) {
+    for (int round = 0; round < 16; round++) {
+      for (size_t i = 0; i < n; i++)
+        hay[i] = "aAb-"[next_random() % 4];
+      hay[n] = '\0';
+      size_t m = next_random() % (round < 8 ? 4 : 40);
+      for (size_t i = 0; i < m; i++)
+        needle[i] = n && round % 2 == 0 ? hay[(n / 2 + i) % n] : "aAb-"[next_random() % 4];
+      needle[m] = '\0';
+      zstr s = zstr_from(hay);
+      const char *found = strstr(hay, needle);
+      ptrdiff_t want = found ? found - hay : -1;
+      if (!TEST_CHECK(zstr_find(&s, needle) == want))
+        TEST_MSG("hay %zu, needle %zu", n, m);
+      TEST_CHECK(zstr_contains(&s, needle) == (want >= 0));
+      zstr_free(&s);
+    }
+  }
+}
+
+TEST_LIST = {
+    {"levels available", test_levels_available},
+    {"lower", test_lower},
+    {"plain span", test_plain_span},
+    {"charset scan", test_charset_scan},
+    {"find", test_find},
+    {"zstr case", test_zstr_case},
+    {"zstr utf8", test_zstr_utf8},
+    {"zstr find", test_zstr_find},
+    {NULL, NULL},
+};
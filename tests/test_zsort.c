@@ -0,0 +1,158 @@
+// Feature test macros for cross-platform compatibility
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "acutest.h"
+#include "zvec.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Generated sorts against qsort()
+// ============================================================================
+//
+// Ids are ranked by a score column the way the selector ranks entries:
+// score desc, then id asc. With the id tiebreak the order is total, so every
+// sort must give exactly qsort()'s permutation. The score-only order leaves
+// ties unordered, there the sorted score sequences must match.
+
+static float *scores;
+
+static inline bool ranks_above(uint32_t a, uint32_t b) {
+  return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+}
+
+static inline bool scores_above(uint32_t a, uint32_t b) {
+  return scores[a] > scores[b];
+}
+
+Z_SORT_GENERATE_IMPL(uint32_t, ranked, ranks_above)
+Z_SORT_GENERATE_IMPL(uint32_t, scored, scores_above)
+
+static int compare_ranked(const void *pa, const void *pb) {
+  uint32_t a = *(const uint32_t *)pa, b = *(const uint32_t *)pb;
+  return ranks_above(a, b) ? -1 : ranks_above(b, a) ? 1 : 0;
+}
+
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t next_random(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 7;
+  rng ^= rng << 17;
+  return (uint32_t)rng;
+}
+
+typedef enum {
+  FILL_RANDOM,
+  FILL_FEW,     // Five distinct scores: mostly ties
+  FILL_EQUAL,
+  FILL_SORTED,
+  FILL_REVERSED,
+  FILL_PIPE,    // Rises then falls
+  FILL_COUNT,
+} Fill;
+
+// Scores for ids 0..n-1 and the ids in shuffled order
+static void fill(uint32_t *ids, size_t n, Fill how) {
+  for (size_t i = 0; i < n; i++) {
+    ids[i] = (uint32_t)i;
+    switch (how) {
+    case FILL_RANDOM: scores[i] = (float)(next_random() % 1000000) / 7.0f; break;
+    case FILL_FEW: scores[i] = (float)(next_random() % 5); break;
+    case FILL_EQUAL: scores[i] = 1.0f; break;
+    case FILL_SORTED: scores[i] = (float)i; break;
+    case FILL_REVERSED: scores[i] = (float)(n - i); break;
+    default: scores[i] = (float)(i < n / 2 ? i : n - i); break;
+    }
+  }
+  for (size_t i = n; i > 1; i--) {
+    size_t j = next_random() % i;
+    uint32_t t = ids[i - 1];
+    ids[i - 1] = ids[j];
+    ids[j] = t;
+  }
+}
+
+#define MAX_N 20000
+
+static uint32_t ids[MAX_N], want[MAX_N], got[MAX_N];
+
+// Sizes around the insertion sort cutoff, then larger random ones
+static size_t case_size(int i) {
+  return i < 40 ? (size_t)i : 40 + next_random() % (i % 10 == 0 ? MAX_N - 40 : 2000);
+}
+
+static void prepare(int i, size_t *n) {
+  static float column[MAX_N];
+  scores = column;
+  *n = case_size(i);
+  fill(ids, *n, (Fill)(i % FILL_COUNT));
+  memcpy(want, ids, *n * sizeof(uint32_t));
+  qsort(want, *n, sizeof(uint32_t), compare_ranked);
+  memcpy(got, ids, *n * sizeof(uint32_t));
+}
+
+void test_sort_matches_qsort(void) {
+  for (int i = 0; i < 600; i++) {
+    size_t n;
+    prepare(i, &n);
+    zsort_ranked(got, n);
+    if (!TEST_CHECK(memcmp(got, want, n * sizeof(uint32_t)) == 0))
+      TEST_MSG("n=%zu fill=%d", n, i % FILL_COUNT);
+  }
+}
+
+void test_sort_ties_match_qsort(void) {
+  for (int i = 0; i < 600; i++) {
+    size_t n;
+    prepare(i, &n);
+    zsort_scored(got, n);
+    bool same = true;
+    for (size_t j = 0; j < n; j++)
+      same &= scores[got[j]] == scores[want[j]];
+    if (!TEST_CHECK(same))
+      TEST_MSG("n=%zu fill=%d", n, i % FILL_COUNT);
+  }
+}
+
+void test_nth_matches_qsort(void) {
+  for (int i = 0; i < 600; i++) {
+    size_t n;
+    prepare(i, &n);
+    if (n == 0)
+      continue;
+    size_t k = next_random() % n;
+    zsort_nth_ranked(got, n, k);
+    bool split = got[k] == want[k];
+    for (size_t j = 0; j < n; j++)
+      split &= j < k ? !ranks_above(got[k], got[j]) : j == k || !ranks_above(got[j], got[k]);
+    if (!TEST_CHECK(split))
+      TEST_MSG("n=%zu k=%zu fill=%d", n, k, i % FILL_COUNT);
+  }
+}
+
+void test_partial_matches_qsort(void) {
+  for (int i = 0; i < 600; i++) {
+    size_t n;
+    prepare(i, &n);
+    size_t k = next_random() % (n + 2);
+    zsort_partial_ranked(got, n, k);
+    size_t m = k < n ? k : n;
+    if (!TEST_CHECK(memcmp(got, want, m * sizeof(uint32_t)) == 0))
+      TEST_MSG("n=%zu k=%zu fill=%d", n, k, i % FILL_COUNT);
+  }
+}
+
+TEST_LIST = {
+    {"sort matches qsort", test_sort_matches_qsort},
+    {"sort ties match qsort", test_sort_ties_match_qsort},
+    {"nth matches qsort", test_nth_matches_qsort},
+    {"partial matches qsort", test_partial_matches_qsort},
+    {NULL, NULL},
+};